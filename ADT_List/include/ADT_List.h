@@ -3,6 +3,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdio.h>
 
 // The list is represented by the type List, whilst a list node
 // is represented by the type listNode (incomplete structs)
@@ -24,6 +25,16 @@ typedef struct list_node *listNode;
 // Note 2: make sure to call list_destroy() on every list that's used,
 // when done using it
 
+// Note 3: the list keeps its own copies of the strings that are inserted
+// in it, and deallocates them itself. The strings returned by the list
+// must not be deallocated, and they may be invalidated by any insertion
+// or deletion, as well as by replacing them with list_replace
+
+// There are two implementations of this interface, which are selected
+// at build time: a singly linked list (list.c), and a contiguous array
+// in which the strings are stored inline (list_array.c). In the latter,
+// accessing a node by its index takes O(1) time instead of O(index)
+
 // Creates and returns an empty list (or NIL_LIST in case of error)
 
 List list_create(void);
@@ -32,6 +43,10 @@ List list_create(void);
 
 void list_print(List list);
 
+// Prints a list to the given stream
+
+void list_fprint(List list, FILE *fp);
+
 // Returns the list's size (number of nodes in the list)
 
 size_t list_size(List list);
@@ -74,11 +89,12 @@ char * list_get(List list, int index);
 
 char * list_access(List list, listNode node);
 
-// Replaces a list node's string field with a new string
+// Replaces a list node's string field with (a copy of) a new string
 
 void list_replace(List list, listNode node, char *new_str);
 
-// Inserts a new node at the tail of the list
+// Inserts a new node (with a copy of the given string) at the tail of
+// the list
 
 void list_insert_last(List list, char *str);
 
@@ -101,6 +117,10 @@ void list_delete_last(List list);
 
 void list_delete(List list, listNode node);
 
+// Removes all nodes from the list (the list itself can still be used)
+
+void list_clear(List list);
+
 // Destroys a list (memory deallocation)
 //
 // Usage of said list after its deletion yields undefined behaviour
@@ -17,8 +17,8 @@
 // represented simply as a structure with a string field (i.e. the node's)
 // string value) and a pointer to the next node.
 //
-// Important note: no extra space is allocated for each string in the list,
-// but a pointer to each string is kept instead.
+// Important note: each node keeps its own copy of its string, which is
+// deallocated along with the node.
 
 struct list {
   listNode dummy;
@@ -40,7 +40,13 @@ listNode list_aux_new_node(char *str, listNode next) {
   if ((new_node = malloc(sizeof(*new_node))) == NULL)
     return NIL_NODE;
 
-  new_node->str = str; // We don't use additional memory for str!
+  new_node->str = NULL; // The dummy node doesn't have a string
+
+  if (str != NULL && (new_node->str = strdup(str)) == NULL) {
+    free(new_node);
+    return NIL_NODE;
+  }
+
   new_node->next = next;
 
   return new_node;
@@ -49,6 +55,7 @@ listNode list_aux_new_node(char *str, listNode next) {
 // Destroys a list node (memory deallocation)
 
 void list_aux_destroy_node(listNode node) {
+  free(node->str);
   free(node);
 }
 
@@ -74,14 +81,20 @@ List list_create(void) {
 // Prints a list
 
 void list_print(List list) {
+  list_fprint(list, stdout);
+}
+
+// Prints a list to the given stream
+
+void list_fprint(List list, FILE *fp) {
   listNode curr = list->dummy->next; // first non-dummy node
 
   while (curr != NIL_NODE) {
-    printf("%s%s", curr->str, (curr->next == NIL_NODE) ? "" : " ");
+    fprintf(fp, "%s%s", curr->str, (curr->next == NIL_NODE) ? "" : " ");
     curr = curr->next;
   }
 
-  printf("\n");
+  fprintf(fp, "\n");
 }
 
 // Returns the list's size (number of nodes in the list)
@@ -162,17 +175,22 @@ char * list_access(List list, listNode node) {
   return (node == NIL_NODE) ? NULL : node->str;
 }
 
-// Replaces a list node's string field with a new string
+// Replaces a list node's string field with (a copy of) a new string
 //
-// Attention: the space in which the previous string was stored is _not_
-// deallocated, but it gets overwritten with the new string
+// Attention: the space in which the previous string was stored is reused
+// (and resized, if needed), so it gets overwritten with the new string
 
 void list_replace(List list, listNode node, char *new_str) {
-  if (node != NIL_NODE && new_str != NULL)
-    strcpy(node->str, new_str);
+  if (node == NIL_NODE || new_str == NULL) return;
+
+  char *str = realloc(node->str, strlen(new_str) + 1);
+  if (str == NULL) return;
+
+  node->str = strcpy(str, new_str);
 }
 
-// Inserts a new node at the tail of the list
+// Inserts a new node (with a copy of the given string) at the tail of
+// the list
 
 void list_insert_last(List list, char *str) {
   list_insert_after(list, str, list->last);
@@ -226,6 +244,23 @@ void list_delete(List list, listNode node) {
   list->size--;
 }
 
+// Removes all nodes from the list (the list itself can still be used)
+
+void list_clear(List list) {
+  listNode curr = list->dummy->next; // First non-dummy node
+  listNode temp;
+
+  while (curr != NIL_NODE) {
+    temp = curr;
+    curr = curr->next;
+    list_aux_destroy_node(temp);
+  }
+
+  list->dummy->next = NIL_NODE;
+  list->last = list->dummy;
+  list->size = 0;
+}
+
 // Destroys a list (memory deallocation)
 //
 // Usage of said list after its deletion yields undefined behaviour
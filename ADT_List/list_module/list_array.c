@@ -0,0 +1,276 @@
+// This file contains an alternative implementation of the ADT List, as
+// described in the ADT_List.h interface file. It's selected at build time
+// with "make LIST=array" (see the Makefile)
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "ADT_List.h" // interface file for the ADT List
+
+// In this implementation of the ADT List, the list is a growable array of
+// slots, which is doubled whenever it becomes full. Each slot stores its
+// string inline, unless the string doesn't fit in it, in which case it's
+// allocated separately. This way, the i-th string of the list is found
+// in O(1) time, and traversing a list accesses consecutive memory.
+//
+// A list node is represented by the index of its slot plus one, so that
+// NIL_NODE (i.e. 0) can be used as the end-signalling node. Since the
+// nodes are indices, inserting or deleting a node shifts the nodes that
+// come after it.
+
+#define SLOT_SIZE 40 // Longest string that fits in a slot, plus one ('\0')
+
+struct slot {
+  char *heap;          // The string, if it doesn't fit in str (or NULL)
+  char str[SLOT_SIZE];
+};
+
+struct list {
+  struct slot *slots;
+  size_t size;
+  size_t capacity;
+};
+
+// [Auxiliary] Conversions between nodes and slot indices
+
+static inline size_t node_index(listNode node) {
+  return (uintptr_t) node - 1;
+}
+
+static inline listNode index_node(size_t index) {
+  return (listNode) (uintptr_t) (index + 1);
+}
+
+// [Auxiliary] Returns the string stored in a slot
+
+static inline char * slot_str(struct slot *slot) {
+  return (slot->heap != NULL) ? slot->heap : slot->str;
+}
+
+// [Auxiliary] Stores a copy of a string in a slot, whose previous string
+// (if any) is deallocated. Returns false if the memory cannot be allocated
+
+static bool slot_set(struct slot *slot, char *str) {
+  size_t len = strlen(str);
+
+  if (len < SLOT_SIZE) {
+    free(slot->heap);
+    slot->heap = NULL;
+
+    memcpy(slot->str, str, len + 1);
+    return true;
+  }
+
+  char *heap = realloc(slot->heap, len + 1);
+  if (heap == NULL) return false;
+
+  slot->heap = memcpy(heap, str, len + 1);
+  return true;
+}
+
+// [Auxiliary] Makes room for at least one more slot in the list. Returns
+// false if the memory cannot be allocated
+
+static bool grow(List list) {
+  if (list->size < list->capacity) return true;
+
+  size_t capacity = (list->capacity == 0) ? 4 : 2 * list->capacity;
+
+  struct slot *slots = realloc(list->slots, sizeof(struct slot) * capacity);
+  if (slots == NULL) return false;
+
+  list->slots = slots;
+  list->capacity = capacity;
+
+  return true;
+}
+
+// Creates and returns an empty list (or NIL_LIST in case of error)
+
+List list_create(void) {
+  List list = malloc(sizeof(*list));
+  if (list == NULL) return NIL_LIST;
+
+  list->slots = NULL;
+  list->size = 0;
+  list->capacity = 0;
+
+  return list;
+}
+
+// Prints a list
+
+void list_print(List list) {
+  list_fprint(list, stdout);
+}
+
+// Prints a list to the given stream
+
+void list_fprint(List list, FILE *fp) {
+  for (size_t i = 0; i < list->size; i++)
+    fprintf(fp, "%s%s", slot_str(&list->slots[i]),
+            (i == list->size - 1) ? "" : " ");
+
+  fprintf(fp, "\n");
+}
+
+// Returns the list's size (number of nodes in the list)
+
+size_t list_size(List list) {
+  return list->size;
+}
+
+// Returns true if the list is empty, false otherwise
+
+bool list_is_empty(List list) {
+  return (list->size == 0) ? true : false;
+}
+
+// Returns the first list node that contains the given string
+// (or NIL_NODE, if said string can't be found in the list)
+
+listNode list_search(List list, char *str) {
+  if (str == NULL) return NIL_NODE;
+
+  for (size_t i = 0; i < list->size; i++)
+    if (!strcmp(slot_str(&list->slots[i]), str))
+      return index_node(i);
+
+  return NIL_NODE;
+}
+
+// Returns the first node in a list (or NIL_NODE, if list is empty)
+
+listNode list_begin(List list) {
+  return list_is_empty(list) ? NIL_NODE : index_node(0);
+}
+
+// Returns the succeeding node of a given node in a list (or NIL_NODE, if
+// the given node is NIL_NODE). If the given node is the last node in the
+// list, then list_end(list) is returned
+
+listNode list_next(List list, listNode node) {
+  if (node == NIL_NODE) return NIL_NODE;
+
+  size_t next = node_index(node) + 1;
+  return (next < list->size) ? index_node(next) : NIL_NODE;
+}
+
+// Returns the end-signalling node of a list
+
+listNode list_end(List list) {
+  return NIL_NODE;
+}
+
+// Returns the i-th node in the list (or NIL_NODE, if index is out
+// of bounds)
+
+listNode list_get_node(List list, int index) {
+  if (index < 0 || index >= list->size) return NIL_NODE;
+
+  return index_node(index);
+}
+
+// Returns the ith string in the list (indexing starts at 0).
+// If index is out of bounds, NULL is returned
+
+char * list_get(List list, int index) {
+  if (index < 0 || index >= list->size) return NULL;
+
+  return slot_str(&list->slots[index]);
+}
+
+// Returns the string contained in a given node in a list (or
+// NULL if the given node is NIL_NODE)
+
+char * list_access(List list, listNode node) {
+  return (node == NIL_NODE) ? NULL : slot_str(&list->slots[node_index(node)]);
+}
+
+// Replaces a list node's string field with (a copy of) a new string
+
+void list_replace(List list, listNode node, char *new_str) {
+  if (node != NIL_NODE && new_str != NULL)
+    slot_set(&list->slots[node_index(node)], new_str);
+}
+
+// Inserts a new node (with a copy of the given string) at the tail of
+// the list
+
+void list_insert_last(List list, char *str) {
+  list_insert_after(list, str,
+                    list_is_empty(list) ? NIL_NODE : index_node(list->size - 1));
+}
+
+// Inserts a new node in the list after the given node. If the given node
+// is NIL_NODE, then the new node is inserted at the head of the list
+//
+// Assumption: the given node is either NIL_NODE or exists in the list
+// (otherwise the behaviour of this method is undefined)
+
+void list_insert_after(List list, char *str, listNode node) {
+  if (str == NULL || !grow(list)) return;
+
+  size_t index = (node == NIL_NODE) ? 0 : node_index(node) + 1;
+  struct slot *slot = &list->slots[index];
+
+  // Shift the following nodes one slot to the right
+  memmove(slot + 1, slot, sizeof(struct slot) * (list->size - index));
+
+  slot->heap = NULL;
+
+  if (!slot_set(slot, str)) {
+    memmove(slot, slot + 1, sizeof(struct slot) * (list->size - index));
+    return;
+  }
+
+  list->size++;
+}
+
+// Removes the last node from the list
+
+void list_delete_last(List list) {
+  if (!list_is_empty(list))
+    list_delete(list, index_node(list->size - 1));
+}
+
+// Removes the given node from the list
+//
+// Assumption: the given node exists in the list (otherwise the behaviour
+// of this method is undefined)
+
+void list_delete(List list, listNode node) {
+  if (node == NIL_NODE) return;
+
+  size_t index = node_index(node);
+  struct slot *slot = &list->slots[index];
+
+  free(slot->heap);
+
+  // Shift the following nodes one slot to the left
+  memmove(slot, slot + 1, sizeof(struct slot) * (list->size - index - 1));
+
+  list->size--;
+}
+
+// Removes all nodes from the list (the list itself can still be used)
+
+void list_clear(List list) {
+  for (size_t i = 0; i < list->size; i++)
+    free(list->slots[i].heap);
+
+  list->size = 0; // The slots are kept, so that the list can be refilled
+}
+
+// Destroys a list (memory deallocation)
+//
+// Usage of said list after its deletion yields undefined behaviour
+
+void list_destroy(List list) {
+  list_clear(list);
+
+  free(list->slots);
+  free(list);
+}
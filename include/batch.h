@@ -0,0 +1,10 @@
+#pragma once
+
+// Colors many maps in one process, on a pool of options.n_jobs worker
+// threads. The maps are read from the given files or, if there are none,
+// from options.input_file, where consecutive maps are separated by one or
+// more blank lines. For each map, a status line is printed, followed by
+// the colored map itself (if there is one), in the order of the input.
+// Returns the exit status of the program
+
+int run_batch(char **files, int n_files, char **colors, int max_colors);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Multi-word bitsets (arrays of 64-bit words). The bulk operations are
+// vectorized with AVX2 or SSE2, depending on what the compiler targets
+// (see the SIMD option in the Makefile), and fall back to plain scalar
+// code on other platforms
+
+// Number of words needed for a bitset of n bits
+
+#define BITSET_WORDS(n) (((n) + 63) / 64)
+
+// Single-bit operations
+
+static inline bool bitset_test(const uint64_t *set, int bit) {
+  return (set[bit >> 6] >> (bit & 63)) & 1;
+}
+
+static inline void bitset_set(uint64_t *set, int bit) {
+  set[bit >> 6] |= (uint64_t) 1 << (bit & 63);
+}
+
+static inline void bitset_clear(uint64_t *set, int bit) {
+  set[bit >> 6] &= ~((uint64_t) 1 << (bit & 63));
+}
+
+// Sets the first n bits of a bitset of n_words words (and clears the rest)
+
+void bitset_fill(uint64_t *set, int n_words, int n);
+
+// dst = a | b
+
+void bitset_or(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+               int n_words);
+
+// Returns true if at least one bit is set
+
+bool bitset_any(const uint64_t *set, int n_words);
+
+// Returns the number of bits that are set
+
+int bitset_popcount(const uint64_t *set, int n_words);
+
+// Returns the index of the first set bit that's >= from (-1 if none)
+
+int bitset_next(const uint64_t *set, int n_words, int from);
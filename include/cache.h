@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "ADT_List.h"
+#include "canon.h"
+
+// On-disk cache of colorings (--cache). Each entry is a file in
+// options.cache_dir, named after the canonical hash of a map (see canon.h)
+// and holding a coloring of the map in canonical vertex order, so that
+// it applies to every relabeling of the map as well
+
+// Returns the key under which the coloring of a (valid) map is cached,
+// or NULL if the map can't be cached (it's precolored with colors other
+// than the first n_colors). The key is destroyed with canon_destroy
+
+struct canon * cache_key(List *map, char **colors, int n_colors);
+
+// Looks up the coloring of a map in the cache. If there's one, it's used
+// to paint the uncolored countries of the map, and it's verified with
+// is_valid_coloring. Returns true if the map has been colored this way
+// (otherwise, the map is left as it was)
+
+bool cache_lookup(struct canon *key, List *map, char **colors, int max_colors,
+                  int n_colors);
+
+// Stores the coloring of a (fully colored) map in the cache. The map has
+// to be in the same order as when its key was computed
+
+void cache_store(struct canon *key, List *map, char **colors, int n_colors);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "graph.h"
+
+// Canonical form of a graph, computed with Weisfeiler-Lehman (color
+// refinement): every vertex starts with a label made of its degree and
+// its precolor, and is then repeatedly relabeled with a hash of its own
+// label and the labels of its neighbours, until the partition of the
+// vertices into labels stops getting finer.
+//
+// The hash only depends on the multiset of the final labels, so it's the
+// same for every relabeling of the graph (different line order, different
+// country names). Non-isomorphic graphs may share a hash, so anything that
+// is looked up with it has to be verified.
+
+struct canon {
+  uint64_t hash;     // Invariant hash of the graph (and of the color count)
+  int n_countries;
+  int n_edges;
+  int *order;        // order[k] is the vertex at canonical position k
+};
+
+// Returns the canonical form of a graph whose countries are colored with
+// indices among the first n_colors colors (see graph.h)
+
+struct canon * canon_create(struct graph *g, int n_colors);
+
+// Destroys a canonical form (memory deallocation)
+
+void canon_destroy(struct canon *c);
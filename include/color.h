@@ -3,9 +3,11 @@
 #include <stdbool.h>
 
 #include "ADT_List.h"
+#include "graph.h"
+#include "libmapcol.h"
 
 // Returns true if a map is valid, according to the format specified
-// in parse.c (rules A and B)
+// in parse.c (rules A, B and D)
 
 bool is_map_valid(List *map);
 
@@ -17,6 +19,10 @@ List * map_copy(List *map);
 
 void map_print(List *map);
 
+// Prints a map to the given stream
+
+void map_fprint(List *map, FILE *fp);
+
 // Replaces "nocolor" with a valid color for a country in the map
 
 void paint_country(List *map, int country, char *color);
@@ -60,11 +66,64 @@ bool can_color(List *map, int country, char *color, bool checking_validity);
 
 void sort_map(List *map);
 
+// Returns the integer form of a map, in which the colors of the countries
+// are looked up in the first n_colors entries of the colors array
+
+struct graph * graph_build(List *map, char **colors, int n_colors);
+
 // Colors a map with at most n colors so that two neighbouring countries
 // have different colors. Returns true on success and false on failure
+// (or if the deadline set with set_deadline has passed)
 
 bool color_map(List *map, char **colors, int n_colors);
 
+// Counts the colorings of a map with n colors that leave its precolored
+// countries as they are. Returns the count as a decimal number (which the
+// caller has to free), or NULL if the deadline set with set_deadline
+// passed first
+
+char * count_colorings(List *map, char **colors, int n_colors);
+
+// Prints every coloring of a map with n colors that leaves its precolored
+// countries as they are, as soon as it's found (each one as a map, followed
+// by an empty line). Returns the number of colorings, or -1 if the deadline
+// set with set_deadline passed before they were all printed
+
+long enumerate_colorings(List *map, char **colors, int n_colors);
+
+// Makes color_map, count_colorings and enumerate_colorings give up once
+// the given number of seconds has passed (a non-positive number of seconds
+// means that there's no deadline)
+
+void set_deadline(double seconds);
+
+// Returns true if the last call to color_map gave up because the
+// deadline had passed
+
+bool deadline_expired(void);
+
+// Paints the map with the deepest partial coloring reached by the last
+// call to color_map (the countries it didn't get to are left uncolored)
+
+void restore_best_coloring(List *map);
+
+// Stores in *before and *after the bandwidth of the numbering of the
+// countries (the largest difference between the indices of two neighbours)
+// before and after the last call to color_map renumbered them. Returns
+// false if the countries weren't renumbered (see --renumber)
+
+bool renumber_bandwidth(int *before, int *after);
+
+// Returns the search statistics of the last call to color_map (NULL if
+// there's none)
+
+const struct mapcol_stats * color_map_stats(void);
+
+// Releases what the last call to color_map has kept for the functions
+// above (the next call does it too)
+
+void color_map_free(void);
+
 // Returns true if a map is colored with only the first n_clrs colors
 // of the "clrs" array, in a way such that two neighbouring countries
 // have different colors
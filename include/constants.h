@@ -2,3 +2,7 @@
 
 #define MAX_WORD 32
 #define MAX_COUNTRIES 2048
+
+// Exit status of mapcol when the --timeout deadline expires before the
+// map is colored (a partial coloring is printed in that case)
+#define EXIT_TIMEOUT 2
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <setjmp.h>
+
+// Fatal errors (such as running out of memory). They never end the process
+// from inside the library (see libmapcol.h): every call into it sets a
+// recovery point, to which terminate() jumps back with the error, so that
+// the call fails instead. Anywhere else, the error goes to the handler that
+// the program has set (mapcol prints it and exits)
+
+// Recovery point of the current thread (NULL: none), and the error that
+// terminate() returned to it
+
+extern _Thread_local jmp_buf *fatal_recovery;
+extern _Thread_local char *fatal_error;
+
+// Sets the function that handles the fatal errors outside of the library
+// calls (it must not return)
+
+void set_fatal_handler(void (*handler)(char *msg));
+
+// Reports a fatal error: it's returned to the recovery point of the
+// current thread, if there's one, and it's passed to the handler otherwise
+// (without a handler, it's printed and the process aborts)
+
+void terminate(char *msg);
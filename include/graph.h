@@ -0,0 +1,55 @@
+#pragma once
+
+// Integer form of a (valid) map: country i of the map becomes vertex i, and
+// the neighbours of each vertex are stored in one contiguous array
+// (compressed sparse rows), so that the search doesn't have to deal with
+// strings at all
+
+struct graph {
+  int n_countries;
+  int *offsets;    // Neighbours of v: adj[offsets[v]] ... adj[offsets[v+1]-1]
+  int *adj;
+  int *colors;     // Color of each country, as an index in the colors array
+                   // (-1: uncolored, -2: colored with some other color)
+};
+
+// Returns a graph of n vertices (all of them uncolored), in which the
+// neighbours of each vertex are the heads of the n_arcs arcs (from[i],
+// to[i]) that leave it, in the order of the arcs. An arc that has no
+// reverse arc gets one, after the other neighbours of its head (so an
+// edge can be given as a single arc, or as an arc each way)
+
+struct graph * graph_from_arcs(int n, int n_arcs, const int *from,
+                               const int *to);
+
+// Stores the distinct edges of a graph (self-loops and repeated neighbours
+// are ignored) in two newly allocated arrays: edge i joins vertices
+// (*from)[i] < (*to)[i]. Returns the number of edges
+
+int graph_edges(struct graph *g, int **from, int **to);
+
+// Returns a locality-improving numbering of the vertices of a graph, as
+// an array in which perm[v] is the new number of vertex v (reverse
+// Cuthill-McKee: neighbouring vertices get numbers that are close to each
+// other, so that they're also close to each other in memory)
+
+int * graph_rcm(struct graph *g);
+
+// Returns a copy of a graph in which vertex v has become vertex perm[v]
+
+struct graph * graph_renumber(struct graph *g, int *perm);
+
+// Returns the bandwidth of a graph: the largest difference between the
+// numbers of two neighbouring vertices
+
+int graph_bandwidth(struct graph *g);
+
+// Destroys a graph (memory deallocation)
+
+void graph_destroy(struct graph *g);
+
+// Returns the number of neighbours of a vertex
+
+static inline int graph_degree(struct graph *g, int v) {
+  return g->offsets[v+1] - g->offsets[v];
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <stdbool.h>
+
+// libmapcol: the solver of mapcol as a library (libmapcol.a, libmapcol.so),
+// for programs that would otherwise format a map as text, run mapcol on it
+// and parse its output back.
+//
+// A map is a handle (struct mapcol), which is built either from arrays of
+// borders between countries 0 ... n-1, or country by country, by name. Its
+// countries can be precolored with color indices, and each solve fills in
+// the color index of every country. Colors are indices only: naming them
+// is up to the caller.
+//
+// The library has no global state, so different handles can be used by
+// different threads at the same time (a handle itself isn't synchronized).
+// It never ends the process either: when a call fails, it returns an error
+// status (or -1, or NULL), and mapcol_error tells what went wrong. The map
+// and what the call allocated for it are released as usual (only the
+// working memory of the step that ran out of memory, such as the planarity
+// test or a tree decomposition, may be lost)
+
+struct mapcol;
+
+enum mapcol_status {
+  MAPCOL_OK = 0,
+  MAPCOL_UNCOLORABLE, // There's no coloring with the given number of colors
+  MAPCOL_TIMEOUT,     // The deadline passed before the map was colored
+  MAPCOL_INVALID,     // Invalid argument (see mapcol_error)
+  MAPCOL_ERROR        // Out of memory (see mapcol_error)
+};
+
+// Statistics of the search of a solve (see mapcol_stats). They're kept
+// during every solve, at the cost of a few increments per search node
+
+struct mapcol_stats {
+  double elapsed;        // Seconds since the solve started
+  long nodes;            // Number of search nodes visited
+  long backtracks;       // Number of times a country had to be uncolored
+  long restarts;         // Number of times the search started over
+  int depth;             // Current depth of the search
+  int max_depth;         // Maximum depth reached so far
+  double first_solution; // Seconds until the first solution (-1: none yet)
+  const long *backtracks_at; // backtracks_at[d]: backtracks at depth d,
+  int histogram_size;        // for 0 <= d < histogram_size
+};
+
+struct mapcol_options {
+  int n_colors;        // Number of colors (4 by default)
+  double timeout;      // Seconds until the search gives up (0: never)
+  unsigned long seed;  // Seed of the randomized restarts of the search
+  bool renumber;       // Renumber the countries for locality before the search
+  bool witness;        // Extract a Kuratowski subgraph if the map isn't
+                       // planar (see mapcol_report, this takes quadratic time)
+
+  // Called with the statistics so far every few thousand search nodes (if
+  // it isn't NULL), on the thread of the solve. It mustn't use the map
+
+  void (*progress)(const struct mapcol_stats *stats, void *arg);
+  void *progress_arg;
+};
+
+// What the last solve or count of a map found out on the way (see
+// mapcol_report). The planarity test only runs with 5 colors or more, on
+// maps without precolors, and the tree decomposition only if the planarity
+// test didn't color the map
+
+struct mapcol_report {
+  int planar;          // Outcome of the planarity test (1: planar, 0: not
+                       // planar, -1: not tested)
+  int n_borders;       // Number of distinct borders and of faces of a map
+  int n_faces;         // that the planarity test found to be planar
+  bool k5;             // Kuratowski subgraph of a map that isn't planar (if
+  const int *witness;  // options.witness was set, NULL otherwise): a
+  int n_witness;       // subdivision of K5 (K3,3 if k5 is false), whose
+                       // n_witness borders are witness[2*i]-witness[2*i+1]
+  int width;           // Width of the tree decomposition (-1: not built)
+  bool searched;       // True if the width was too large for dynamic
+                       // programming, so the map was searched instead
+  bool cut_short;      // True if the deadline of a count or enumeration
+                       // passed before it was done
+  int n_precolored;    // If a solve searched the map: the countries that
+  int n_forced;        // were precolored, forced (colored by presolve,
+  int n_searched;      // since they could only take one color) and left to
+  int empty;           // the search, or a country that can't take any
+                       // color (-1: none, the search ran then)
+  int bandwidth_before; // Bandwidth of the numbering of the countries
+  int bandwidth_after;  // before and after renumbering (-1: not renumbered)
+};
+
+// Sets options to the defaults (4 colors, no timeout, seed 0, neither
+// renumbering nor witness, no progress callback)
+
+void mapcol_default_options(struct mapcol_options *o);
+
+// Creates an empty map (NULL if out of memory)
+
+struct mapcol * mapcol_create(void);
+
+// Creates a map of n countries (0 ... n-1) in which country from[i] borders
+// country to[i], for 0 <= i < n_edges (NULL if out of memory, or if an
+// index is out of bounds or a country borders itself)
+
+struct mapcol * mapcol_from_edges(int n, int n_edges, const int *from,
+                                  const int *to);
+
+// Returns the index of the country with the given name, which is added to
+// the map (without borders) if it isn't there yet. Returns -1 on error
+
+int mapcol_country(struct mapcol *m, const char *name);
+
+// Adds a country and its neighbours by name, as a line of mapcol's input
+// does (the neighbours are added too, if they aren't there yet). A border
+// only needs to be listed by one of its countries, and the neighbours of a
+// country are kept in the order in which it lists them (the solver may
+// break ties by that order). Returns the index of the country, or -1 on
+// error
+
+int mapcol_add(struct mapcol *m, const char *name, const char **neighbours,
+               int n_neighbours);
+
+// Adds a border between two countries (given by index)
+
+enum mapcol_status mapcol_border(struct mapcol *m, int a, int b);
+
+// Precolors a country with a color index (-1 removes its precolor). A
+// precolor beyond the number of colors of a solve is taken as a color that
+// no other country can have, as mapcol does with colors outside its palette
+
+enum mapcol_status mapcol_precolor(struct mapcol *m, int country, int color);
+
+// Returns the number of countries of a map
+
+int mapcol_size(struct mapcol *m);
+
+// Returns the name of a country (NULL if it was added by index only)
+
+const char * mapcol_name(struct mapcol *m, int country);
+
+// Colors a map (options can be NULL, for the defaults). On success, the
+// colors can be read with mapcol_colors. On MAPCOL_TIMEOUT, they hold the
+// deepest partial coloring that the search reached instead
+
+enum mapcol_status mapcol_solve(struct mapcol *m,
+                                const struct mapcol_options *options);
+
+// Returns the color index of each country after the last solve: its
+// precolor if it has one, and -1 if it wasn't colored (or if the map has
+// been enumerated since). The array belongs to the map, and it's valid
+// until the map changes or is destroyed
+
+const int * mapcol_colors(struct mapcol *m);
+
+// Counts the colorings of a map with n_colors colors that leave its
+// precolored countries as they are, and stores the count in *count, as a
+// decimal number. The string belongs to the map, and it's valid until the
+// next call on it. Maps that are too wide for dynamic programming are
+// counted by backtracking, which gives up after timeout seconds (0: never)
+// with MAPCOL_TIMEOUT (and *count set to NULL)
+
+enum mapcol_status mapcol_count(struct mapcol *m, int n_colors, double timeout,
+                                const char **count);
+
+// Calls found with each coloring of a map with n_colors colors that leaves
+// its precolored countries as they are (colors is in the format of
+// mapcol_colors, and it's only valid during the call), as soon as it's
+// found, until timeout seconds have passed (0: never, see cut_short in
+// mapcol_report). Returns the number of colorings found, or -1 on error
+
+long mapcol_enumerate(struct mapcol *m, int n_colors, double timeout,
+                      void (*found)(const int *colors, void *arg), void *arg);
+
+// Returns the statistics of the search of the last solve of a map (they
+// belong to the map, and they're valid until the next solve)
+
+const struct mapcol_stats * mapcol_stats(struct mapcol *m);
+
+// Returns what the last solve, count or enumeration of a map found out on
+// the way (it belongs to the map, and it's valid until the next one)
+
+const struct mapcol_report * mapcol_report(struct mapcol *m);
+
+// Returns a description of the last error of a map (NULL if there's none)
+
+const char * mapcol_error(struct mapcol *m);
+
+// Destroys a map (memory deallocation)
+
+void mapcol_destroy(struct mapcol *m);
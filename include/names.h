@@ -0,0 +1,33 @@
+#pragma once
+
+// A hash table that maps country names to indices (0, 1, 2, ...), so that
+// looking up a country doesn't require a linear scan over the map (see
+// find_country in color.c)
+
+struct names;
+
+// Creates and returns an empty table (or NULL in case of error)
+
+struct names * names_create(void);
+
+// Returns the index of a name in the table (-1 if it's not there)
+
+int names_find(struct names *table, char *name);
+
+// Adds a name to the table (a copy of it is kept) and returns its index,
+// which is the number of names added before it. If the name is already
+// in the table, its existing index is returned (-1 in case of error)
+
+int names_add(struct names *table, char *name);
+
+// Returns the name that has the given index (NULL if out of bounds)
+
+char * names_get(struct names *table, int index);
+
+// Returns the number of names in the table
+
+int names_count(struct names *table);
+
+// Destroys a table (memory deallocation)
+
+void names_destroy(struct names *table);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdio.h>
+
+// Color palettes. The first colors of a palette are either read from a
+// file (-p) or are the default ones ("red", "green", ..., "grey"), and if
+// more colors are needed, they get generated names ("color11", ...)
+
+// Number of default colors
+
+#define DEFAULT_COLORS 10
+
+// Returns a palette with at least n_colors colors. If fp isn't NULL, the
+// first colors are read from it (words separated by whitespace), instead
+// of being the default ones. The number of colors in the palette is stored
+// in *size. Returns NULL if a color name is invalid or appears twice, or
+// if the memory cannot be allocated
+
+char ** palette_create(int n_colors, FILE *fp, int *size);
+
+// Returns the index of a color in the palette (-1 if it isn't there)
+
+int palette_find(char **palette, int size, char *color);
+
+// Destroys a palette (memory deallocation)
+
+void palette_destroy(char **palette, int size);
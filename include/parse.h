@@ -12,6 +12,13 @@ bool is_valid(int token);
 
 bool is_whitespace(int token);
 
+// Reads a map description from fp into map, an array of MAX_COUNTRIES
+// empty lists (see map_create). Returns NULL on success, or a message
+// describing the error otherwise (the words read up to that point are
+// kept in map, so that they can be deallocated with map_reset/cleanup)
+
+char * read_map_into(FILE *fp, List *map);
+
 // Returns the map description represented as an adjacency list
 
 List * read_map(FILE *fp);
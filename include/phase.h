@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Phase-scoped instrumentation: the wall and CPU time of each phase of a
+// run (read_map, is_map_valid, color_map, ...) is recorded between calls
+// to phase_begin() and phase_end(). On Linux, the hardware performance
+// counters of each phase (cycles, instructions, cache misses and branch
+// misses) can also be recorded, through perf_event_open(2)
+
+// Enables the instrumentation (it's disabled by default, in which case the
+// rest of the methods do nothing). If hw_counters is true, the hardware
+// performance counters are recorded too (when the platform allows it)
+
+void phase_init(bool hw_counters);
+
+// Starts timing a new phase (phases can't be nested)
+
+void phase_begin(char *name);
+
+// Stops timing the current phase
+
+void phase_end(void);
+
+// Prints the recorded phases to stderr, as a single JSON line
+
+void phase_report(void);
+
+// Releases the resources used by the instrumentation
+
+void phase_cleanup(void);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "graph.h"
+
+// Planarity testing, with the left-right algorithm (de Fraysseix and
+// Rosenstiehl, as formulated by Brandes), which takes linear time. For a
+// planar graph, it produces a combinatorial embedding: the neighbours of
+// each vertex in clockwise order. For a non-planar graph, it can produce
+// a witness instead: the edges of a subdivision of K5 or K3,3 (Kuratowski)
+
+struct planarity {
+  bool planar;
+  int n_countries;
+  int n_edges;     // Number of distinct edges (see graph_edges)
+
+  // If planar: the neighbours of v in clockwise order are rotation[i],
+  // for offsets[v] <= i < offsets[v+1], and the embedding has n_faces faces
+
+  int *offsets;
+  int *rotation;
+  int n_faces;
+
+  // If not planar (and a witness was asked for): edge i of the Kuratowski
+  // subgraph joins witness[2*i] and witness[2*i+1]
+
+  int *witness;
+  int n_witness;
+  bool k5;         // True for a subdivision of K5, false for K3,3
+};
+
+// Tests whether a graph is planar. If it isn't and witness is true, a
+// Kuratowski subgraph is extracted too (which takes quadratic time, since
+// it's done by deleting every edge that the graph stays non-planar without)
+
+struct planarity * planarity_test(struct graph *g, bool witness);
+
+// Destroys the result of a planarity test (memory deallocation)
+
+void planarity_destroy(struct planarity *p);
+
+// Colors a planar graph with 5 colors, ignoring its precolored countries
+// (color[v] is set to 0 ... 4 for every v). Returns false if the graph
+// turns out not to be planar, in which case color is left unspecified
+
+bool planar_five_color(struct graph *g, int *color);
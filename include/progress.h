@@ -0,0 +1,27 @@
+#pragma once
+
+#include "libmapcol.h"
+
+// Progress reports of the search (--stats), printed to stderr. The solver
+// (see libmapcol.h) only passes its statistics to a callback every few
+// thousand search nodes, so the reports are requested asynchronously (by a
+// timer, or by SIGUSR1), and printed by that callback (progress_check)
+
+// Requests a progress report every second, and whenever the process
+// receives SIGUSR1 (until progress_stop is called)
+
+void progress_start(void);
+
+// Stops the periodic progress reports, and restores the signal handlers
+// and the timer that were there before progress_start
+
+void progress_stop(void);
+
+// Prints search statistics to stderr, prefixed with label
+
+void progress_print(char *label, const struct mapcol_stats *stats);
+
+// Prints a progress report if one has been requested (it's the progress
+// callback of the solves, see struct mapcol_options)
+
+void progress_check(const struct mapcol_stats *stats, void *arg);
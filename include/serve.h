@@ -0,0 +1,13 @@
+#pragma once
+
+#include "ADT_List.h"
+
+// Resident mode: colors the given (valid) map, then keeps the map and its
+// coloring in memory and applies edit commands to them, read from stdin
+// or, if options.socket_path is set, from the clients of a local Unix
+// socket. After each edit, the coloring is repaired locally around the
+// edited countries, and only the countries whose color changed are
+// printed (see serve.c for the command protocol). Returns the exit status
+// of the program
+
+int serve(List *map, char **colors, int max_colors);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "graph.h"
+#include "planar.h"
+#include "treedec.h"
+
+// The solver behind color_map, on the integer form of a map (see graph.h):
+// the planar and tree decomposition fast paths, presolve, and the search
+// with restarts. It doesn't read the command line options or any other
+// global state (everything it needs and finds is in a struct solve), so
+// any number of solves can run at the same time
+
+struct solve {
+  // Settings (see solve_init for their defaults)
+
+  int n_colors;
+  double deadline;     // Time (see stats_now) at which the search gives up
+                       // (0: never)
+  unsigned long seed;  // Seed of the randomized restarts of the search
+  bool renumber;       // Renumber the vertices for locality before the search
+  bool witness;        // Extract a Kuratowski subgraph if the planarity test
+                       // finds that the graph isn't planar (see planar.h)
+
+  // Outcome (set by solve_graph)
+
+  int *color;          // Color of each uncolored vertex (on success)
+  bool expired;        // True if the search gave up because of the deadline
+  int *best;           // Deepest partial coloring of the search (-1:
+                       // uncolored), if the deadline passed (NULL otherwise)
+  int best_pos;        // Number of vertices colored in best
+
+  int bandwidth_before; // Bandwidth of the numbering before and after the
+  int bandwidth_after;  // renumbering (-1: not renumbered)
+
+  struct planarity *planarity; // Result of the planarity test (NULL: none)
+  int width;           // Width of the tree decomposition (see treedec_color,
+                       // -1: not built)
+
+  bool searched;       // True if the fast paths left the graph to the search,
+  int n_precolored;    // in which case presolve colored n_forced vertices,
+  int n_forced;        // and left n_searched to the search (or found out that
+  int n_searched;      // vertex empty can't take any color, if it's not -1)
+  int empty;
+
+  // Scratch memory of solve_graph (NULL when it isn't running). It's kept
+  // here so that solve_free can release it even if solve_graph never
+  // returned, because terminate() jumped out of it (see fatal.h)
+
+  struct search *search, *probe;
+  struct graph *renumbered;
+  int *perm;
+};
+
+// Sets up a solve with n_colors colors, no deadline, seed 0, and neither
+// renumbering nor witness
+
+void solve_init(struct solve *sv, int n_colors);
+
+// Colors the uncolored vertices of a graph (see graph.h) around its
+// precolored ones. Returns true on success, and false if there's no
+// coloring or the deadline has passed (sv->expired). Each struct solve is
+// used for one graph only
+
+bool solve_graph(struct solve *sv, struct graph *g);
+
+// Releases the memory used by a solve (including the scratch memory of a
+// solve_graph that didn't return)
+
+void solve_free(struct solve *sv);
@@ -0,0 +1,81 @@
+#pragma once
+
+// Search statistics, updated by the solver while it runs. The counters
+// are plain increments, so they are always kept (even without --stats)
+
+struct search_stats {
+  long nodes;           // Number of search nodes (color_map calls) visited
+  long backtracks;      // Number of times a country had to be uncolored
+  long restarts;        // Number of times the search started over
+  int depth;            // Current depth of the search
+  int max_depth;        // Maximum depth reached so far
+  long *backtracks_at;  // Histogram: backtracks_at[d] = backtracks at depth d
+  int histogram_size;   // Number of entries in backtracks_at
+  double start;         // Time (in seconds) at which the search started
+  double first_solution; // Time to first solution (or -1 if none yet)
+  void (*progress)(void *arg); // Called every PROGRESS_INTERVAL nodes (if
+  void *progress_arg;          // it isn't NULL), with progress_arg
+};
+
+// The statistics are per thread, so that maps can be colored concurrently
+
+extern _Thread_local struct search_stats stats;
+
+// Number of search nodes between two calls to the progress callback (a
+// power of 2)
+
+#define PROGRESS_INTERVAL 4096
+
+// Resets the counters for a search over a map with n_countries countries,
+// and sets its progress callback (NULL: none)
+
+void stats_start(int n_countries, void (*progress)(void *arg), void *arg);
+
+// Releases the memory used by the statistics
+
+void stats_free(void);
+
+// Returns the time elapsed since an arbitrary fixed point (in seconds)
+
+double stats_now(void);
+
+// Called whenever the search enters a new node
+
+static inline void stats_enter(void) {
+  stats.nodes++;
+
+  if (++stats.depth > stats.max_depth)
+    stats.max_depth = stats.depth;
+
+  if (stats.progress != NULL && (stats.nodes & (PROGRESS_INTERVAL - 1)) == 0)
+    stats.progress(stats.progress_arg);
+}
+
+// Called whenever the search leaves a node
+
+static inline void stats_leave(void) {
+  stats.depth--;
+}
+
+// Called whenever a country is uncolored by the search (backtracking)
+
+static inline void stats_backtrack(void) {
+  stats.backtracks++;
+
+  if (stats.depth < stats.histogram_size)
+    stats.backtracks_at[stats.depth]++;
+}
+
+// Called whenever the search gives up on an attempt and starts over
+
+static inline void stats_restart(void) {
+  stats.restarts++;
+  stats.depth = 0;
+}
+
+// Called whenever the search has colored the whole map
+
+static inline void stats_solution(void) {
+  if (stats.first_solution < 0)
+    stats.first_solution = stats_now() - stats.start;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "graph.h"
+
+// Exact coloring of graphs of small treewidth. A tree decomposition is
+// built from a min-degree elimination order (every vertex forms a bag
+// with its neighbours that are eliminated after it), and the colorings of
+// the bags are combined by dynamic programming, from the leaves of the
+// decomposition to its roots. This takes time linear in the size of the
+// graph for a fixed width, and it either finds a coloring or proves that
+// there's none. The same tables count the colorings of the graph (with one
+// count per coloring of each separator, i.e. per state of the frontier
+// between a subtree and the rest of the graph), and enumerate them without
+// ever running into a dead end. Counting and enumerating fall back to
+// backtracking on graphs that are too wide for the tables (bounded by a
+// deadline, since it takes time proportional to the number of colorings)
+
+// Decompositions whose bags have more than TREEDEC_MAX_STATES colorings
+// (without their own vertex) are given up, and so are those wider than
+// TREEDEC_MAX_WIDTH
+
+#define TREEDEC_MAX_STATES (1 << 12)
+#define TREEDEC_MAX_WIDTH 16
+
+// Returns the largest width of a decomposition for n_colors colors (wider
+// ones are given up)
+
+int treedec_limit(int n_colors);
+
+enum treedec_outcome {
+  TREEDEC_COLORED,    // color holds a coloring
+  TREEDEC_UNCOLORABLE,
+  TREEDEC_TOO_WIDE    // The width is above the limit (nothing was decided)
+};
+
+// Colors the uncolored countries of a graph with colors 0 ... n_colors-1,
+// around its precolored ones (color[v] is set for every uncolored v). The
+// width of the decomposition is stored in *width (or the largest width
+// allowed plus one, if the decomposition was given up)
+
+enum treedec_outcome treedec_color(struct graph *g, int n_colors, int *color,
+                                   int *width);
+
+// Counts the colorings of the uncolored countries of a graph with colors
+// 0 ... n_colors-1, around its precolored ones. Returns the count as a
+// decimal number (which the caller has to free). If the decomposition is
+// too wide (see *width, which is set as in treedec_color), they're counted
+// by backtracking instead, which gives up once the deadline has passed
+// (see stats_now, 0: no deadline) and returns NULL
+
+char * treedec_count(struct graph *g, int n_colors, int *width,
+                     double deadline);
+
+// Calls visit(color, arg) for every coloring of the uncolored countries
+// of a graph with colors 0 ... n_colors-1, around its precolored ones
+// (color[v] is set for every uncolored v), as soon as it's found, until
+// the deadline passes (see stats_now, 0: no deadline, and *expired is set
+// if it did). Returns the number of colorings found. If the decomposition
+// is too wide (see *width, which is set as in treedec_color), they're
+// found by backtracking instead
+
+long treedec_enumerate(struct graph *g, int n_colors,
+                       void (*visit)(int *color, void *arg), void *arg,
+                       int *width, double deadline, bool *expired);
@@ -3,15 +3,36 @@
 #include <stdbool.h>
 
 #include "ADT_List.h"
+#include "fatal.h" // terminate()
 
 struct options {
   FILE *input_file; // This is stdin by default, and is changed if -i is given
   bool c_activated; // Program only checks if input map is colored correctly
   int n_colors;     // This is 4 by default, and is changed if -n is given
+  char *palette_path; // File with the names of the colors (-p)
   int n_countries;  // Additional info: how many countries the map contains
+  bool stats;       // Report search statistics (--stats) to stderr
+  bool phases;      // Report per-phase wall/CPU times (--phases) to stderr
+  bool perf;        // Also record hardware counters per phase (--perf)
+  double timeout;   // Seconds until color_map gives up (--timeout, 0: never)
+  bool batch;       // Color many maps in one process (--batch)
+  int n_jobs;       // Number of worker threads in batch mode (--jobs)
+  char **files;     // Input files in batch mode (the remaining arguments)
+  int n_files;      // Number of input files in batch mode
+  bool serve;       // Keep the map in memory and apply edits (--serve)
+  char *socket_path; // Unix socket for the edit commands (--socket)
+  char *cache_dir;  // Directory of the coloring cache (--cache, NULL: none)
+  bool renumber;    // Renumber the countries for locality (--renumber)
+  unsigned long seed; // Seed of the randomized restarts of the search (--seed)
+  bool count;       // Count the colorings of the map instead (--count)
+  bool enumerate;   // Print every coloring of the map instead (--enumerate)
+  bool witness;     // Extract the Kuratowski subgraph of non-planar maps (--witness)
 };
 
-extern struct options options;
+// Each thread has its own copy of the options (see batch.c), since
+// n_countries describes the map that the thread is working on
+
+extern _Thread_local struct options options;
 
 // Processes Command Line Arguments
 //
@@ -19,12 +40,56 @@ extern struct options options;
 // -i <file> : <file> becomes the input stream
 // -c : program only checks if input map is colored correctly
 // -n <num> : specifies how many colors can be used to color input map
+// -p <file> : the names of the colors are read from <file>
+// --stats : search statistics are reported to stderr (periodically, on
+//           SIGUSR1 and at the end of the run)
+// --witness : with --stats, a map that the planarity test finds to be
+//             non-planar is reported along with its Kuratowski subgraph
+//             (which takes quadratic time, unlike the rest of --stats)
+// --phases : the wall and CPU time of each phase is reported to stderr
+// --perf : same as --phases, but hardware counters are recorded as well
+// --timeout <sec> : the search gives up after <sec> seconds, and the deepest
+//                   partial coloring it found is printed instead (a count or
+//                   an enumeration that backtracks is cut short)
+// --batch [<file>...] : many maps are colored, either from the given files
+//                       or from the input stream (separated by blank lines)
+// --jobs <num> : number of worker threads used in batch mode
+// --serve : resident mode, the map is kept in memory and edit commands
+//           are read from stdin (see serve.c)
+// --socket <path> : same as --serve, but the commands are read from the
+//                   clients of a Unix socket that's created at <path>
+// --cache <dir> : colorings are stored in (and looked up from) a cache in
+//                 <dir>, keyed by a hash of the map that doesn't depend on
+//                 the order of the lines or the names of the countries
+// --renumber : the countries are renumbered for memory locality (reverse
+//              Cuthill-McKee) before the search, and the bandwidth of the
+//              numbering before and after that is reported to stderr (maps
+//              that the planar or tree decomposition fast path colors are
+//              never searched, so they aren't renumbered either)
+// --seed <num> : seed of the random tie-breaking that the search uses when
+//                it restarts (it only affects the restarts: maps that are
+//                colored by a fast path, or before the first restart, get
+//                the same coloring whatever the seed)
+// --count : the number of colorings of the map (that leave its precolored
+//           countries as they are) is printed, instead of one of them
+// --enumerate : every coloring of the map is printed, one after the other
 
 void process_CLA(int argc, char **argv);
 
-// Prints msg and terminates the program
+// Prints msg and terminates the program (the fatal error handler of the
+// programs, see fatal.h)
+
+void exit_on_fatal(char *msg);
+
+// Returns an array of MAX_COUNTRIES empty lists, in which a map
+// description can be stored (see read_map_into)
+
+List * map_create(void);
+
+// Empties the map description list, so that it can be reused for
+// another map (the lists themselves are kept)
 
-void terminate(char *msg);
+void map_reset(List *map);
 
 // Deallocates the map description list
 
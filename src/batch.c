@@ -0,0 +1,355 @@
+// Batch mode: colors many maps in one process, on a pool of worker
+// threads. Each worker allocates its map description (MAX_COUNTRIES
+// lists) once and reuses it for every map it colors, so that the cost
+// of processing a small map isn't dominated by setting it up.
+//
+// The maps are handed out to the workers in input order, and each worker
+// writes its results into a memory buffer. The main thread then prints
+// these buffers in input order, as soon as each of them is ready.
+//
+// A fatal error while a map is processed (e.g. running out of memory) only
+// fails that map: each one is processed under a recovery point (see
+// fatal.h), and the error becomes its status line.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <setjmp.h>
+
+#include "utilities.h"
+#include "constants.h"
+#include "ADT_List.h"
+#include "color.h"
+#include "parse.h"
+#include "batch.h"
+#include "cache.h"
+#include "fatal.h"
+
+struct job {
+  char *source;       // Path of the input file (or NULL for stream maps)
+  char *text;         // Map description (for maps read from a stream)
+  size_t text_size;
+  char *output;       // Status line & colored map, produced by a worker
+  size_t output_size;
+  int status;         // Exit status that corresponds to this map
+  bool done;          // True once output is ready to be printed
+};
+
+struct pool {
+  struct job *jobs;
+  int n_jobs;
+  int next_job;           // Index of the next job to be handed out
+  pthread_mutex_t lock;   // Protects next_job and the jobs' done fields
+  pthread_cond_t done;    // Signalled whenever a job is done
+  struct options *opts;   // Options of the main thread
+  char **colors;
+  int max_colors;
+};
+
+// Cache key of the map that a worker is solving. It's kept here rather than
+// in solve, so that it can be released after a fatal error (see
+// process_job)
+
+static _Thread_local struct canon *key = NULL;
+
+// [Auxiliary] Returns true if a line contains nothing but whitespace
+
+static bool is_blank(char *line) {
+  for (int i = 0; line[i] != '\0' && line[i] != '\n'; i++)
+    if (!is_whitespace(line[i]))
+      return false;
+
+  return true;
+}
+
+// [Auxiliary] Appends a new job to the (dynamically growing) jobs array
+
+static struct job * add_job(struct job **jobs, int *n_jobs, int *capacity) {
+  if (*n_jobs == *capacity) {
+    *capacity = (*capacity == 0) ? 64 : 2 * *capacity;
+
+    *jobs = realloc(*jobs, sizeof(struct job) * *capacity);
+    if (*jobs == NULL) terminate("run_batch: out of memory");
+  }
+
+  struct job *job = &(*jobs)[(*n_jobs)++];
+  memset(job, 0, sizeof(*job));
+
+  return job;
+}
+
+// [Auxiliary] Splits the input stream into maps (separated by blank lines)
+// and creates a job for each one of them. Returns the number of jobs
+
+static int split_stream(FILE *fp, struct job **jobs) {
+  int n_jobs = 0, capacity = 0;
+
+  char buf[4096]; // Line buffer (same as in read_map)
+  FILE *text = NULL;
+  struct job *job = NULL;
+
+  *jobs = NULL;
+
+  while (fgets(buf, sizeof(buf), fp)) {
+    if (is_blank(buf)) {
+      if (text != NULL) fclose(text); // The current map (if any) is over
+
+      text = NULL;
+      continue;
+    }
+
+    if (text == NULL) {
+      job = add_job(jobs, &n_jobs, &capacity);
+
+      text = open_memstream(&job->text, &job->text_size);
+      if (text == NULL) terminate("run_batch: out of memory");
+    }
+
+    fputs(buf, text);
+  }
+
+  if (text != NULL) fclose(text);
+
+  return n_jobs;
+}
+
+// [Auxiliary] Colors the map read from "in" (using the worker's map and
+// non_sorted lists), writing the status line and the result to "out".
+// Returns the exit status that corresponds to the map
+
+static int solve(struct pool *pool, FILE *in, FILE *out, List *map,
+                 List *non_sorted) {
+  int status = 0;
+
+  // Each map gets its own time budget
+  set_deadline(options.timeout);
+
+  char *error = read_map_into(in, map);
+
+  if (error != NULL) {
+    fprintf(out, "%s\n", error);
+    status = EXIT_FAILURE;
+    goto reset_map;
+  }
+
+  if (!is_map_valid(map)) {
+    fprintf(out, "map is invalid (format rules weren't met)\n");
+    status = EXIT_FAILURE;
+    goto reset_map;
+  }
+
+  if (options.c_activated) {
+    fprintf(out, "map is %scolored correctly\n",
+            is_valid_coloring(map, pool->colors, pool->max_colors,
+                              options.n_colors) ? "" : "not ");
+    goto reset_map;
+  }
+
+  // Same as in mapcol.c: a cached coloring replaces the search
+
+  if (options.cache_dir != NULL
+   && (key = cache_key(map, pool->colors, options.n_colors)) != NULL
+   && cache_lookup(key, map, pool->colors, pool->max_colors,
+                   options.n_colors)) {
+    fprintf(out, "colored (cached)\n");
+    map_fprint(map, out);
+    goto reset_map;
+  }
+
+  // Same as in mapcol.c: keep the input order for printing
+  memcpy(non_sorted, map, sizeof(List) * options.n_countries);
+  sort_map(map);
+
+  bool colored = color_map(map, pool->colors, options.n_colors);
+
+  bool timed_out = deadline_expired();
+  if (timed_out) restore_best_coloring(map);
+
+  if (colored)
+    fprintf(out, "colored");
+  else if (timed_out)
+    fprintf(out, "deadline expired, partially colored");
+  else
+    fprintf(out, "cannot be colored with %d colors", options.n_colors);
+
+  if (options.stats)
+    fprintf(out, " (nodes: %ld, backtracks: %ld)", color_map_stats()->nodes,
+            color_map_stats()->backtracks);
+
+  int before, after;
+
+  if (renumber_bandwidth(&before, &after))
+    fprintf(out, " (bandwidth: %d -> %d)", before, after);
+
+  fprintf(out, "\n");
+
+  if (colored || timed_out) map_fprint(non_sorted, out);
+  if (timed_out) status = EXIT_TIMEOUT;
+  if (colored && key != NULL)
+    cache_store(key, non_sorted, pool->colors, options.n_colors);
+
+  color_map_free();
+
+reset_map:
+
+  if (key != NULL) canon_destroy(key);
+  key = NULL;
+
+  map_reset(map);
+  return status;
+}
+
+// [Auxiliary] Processes the i-th job, using the worker's lists
+
+static void process_job(struct pool *pool, int i, List *map, List *non_sorted) {
+  struct job *job = &pool->jobs[i];
+
+  FILE *out = open_memstream(&job->output, &job->output_size);
+  if (out == NULL) terminate("run_batch: out of memory");
+
+  fprintf(out, "map %d", i+1);
+  if (job->source != NULL) fprintf(out, " (%s)", job->source);
+  fprintf(out, ": ");
+
+  FILE *in = (job->source != NULL)
+           ? fopen(job->source, "r")
+           : fmemopen(job->text, job->text_size, "r");
+
+  // If a fatal error occurs, the map is failed with it (what solve had
+  // set up is released, and the worker goes on with the next map)
+
+  jmp_buf recovery;
+
+  if (in == NULL) {
+    fprintf(out, "cannot open input\n");
+    job->status = EXIT_FAILURE;
+  } else if (setjmp(recovery)) {
+    fatal_recovery = NULL;
+    fprintf(out, "%s\n", fatal_error);
+    job->status = EXIT_FAILURE;
+
+    color_map_free();
+
+    if (key != NULL) canon_destroy(key);
+    key = NULL;
+
+    map_reset(map);
+    fclose(in);
+  } else {
+    fatal_recovery = &recovery;
+    job->status = solve(pool, in, out, map, non_sorted);
+    fatal_recovery = NULL;
+
+    fclose(in);
+  }
+
+  fclose(out);
+
+  free(job->text);
+  job->text = NULL;
+}
+
+// [Auxiliary] Worker thread: processes jobs until there are none left
+
+static void * worker(void *arg) {
+  struct pool *pool = arg;
+
+  options = *pool->opts; // The options are thread-local (see utilities.h)
+
+  List *map = map_create();
+  List *non_sorted = malloc(sizeof(List) * MAX_COUNTRIES);
+  if (non_sorted == NULL) terminate("run_batch: out of memory");
+
+  while (true) {
+    pthread_mutex_lock(&pool->lock);
+    int i = pool->next_job++;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (i >= pool->n_jobs) break;
+
+    process_job(pool, i, map, non_sorted);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->jobs[i].done = true;
+    pthread_cond_broadcast(&pool->done);
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  cleanup(map);
+  free(non_sorted);
+
+  return NULL;
+}
+
+// Colors many maps in one process, on a pool of options.n_jobs worker
+// threads. The maps are read from the given files or, if there are none,
+// from options.input_file, where consecutive maps are separated by one or
+// more blank lines. For each map, a status line is printed, followed by
+// the colored map itself (if there is one), in the order of the input.
+// Returns the exit status of the program
+
+int run_batch(char **files, int n_files, char **colors, int max_colors) {
+  struct pool pool;
+
+  if (n_files > 0) {
+    pool.n_jobs = n_files;
+
+    pool.jobs = calloc(n_files, sizeof(struct job));
+    if (pool.jobs == NULL) terminate("run_batch: out of memory");
+
+    for (int i = 0; i < n_files; i++)
+      pool.jobs[i].source = files[i];
+  } else {
+    pool.n_jobs = split_stream(options.input_file, &pool.jobs);
+  }
+
+  pool.next_job = 0;
+  pool.opts = &options;
+  pool.colors = colors;
+  pool.max_colors = max_colors;
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.done, NULL);
+
+  int n_workers = options.n_jobs;
+  if (n_workers > pool.n_jobs) n_workers = pool.n_jobs;
+
+  pthread_t *workers = malloc(sizeof(pthread_t) * (n_workers + 1));
+  if (workers == NULL) terminate("run_batch: out of memory");
+
+  for (int i = 0; i < n_workers; i++)
+    if (pthread_create(&workers[i], NULL, worker, &pool) != 0)
+      terminate("run_batch: cannot create worker thread");
+
+  // Print the results in input order. The exit status is the "worst" one
+  // among the maps: failure (e.g. invalid map), then timeout, then success
+
+  int status = 0;
+
+  for (int i = 0; i < pool.n_jobs; i++) {
+    pthread_mutex_lock(&pool.lock);
+
+    while (!pool.jobs[i].done)
+      pthread_cond_wait(&pool.done, &pool.lock);
+
+    pthread_mutex_unlock(&pool.lock);
+
+    fwrite(pool.jobs[i].output, 1, pool.jobs[i].output_size, stdout);
+    free(pool.jobs[i].output);
+
+    if (pool.jobs[i].status == EXIT_FAILURE || status == 0)
+      status = pool.jobs[i].status;
+  }
+
+  for (int i = 0; i < n_workers; i++)
+    pthread_join(workers[i], NULL);
+
+  pthread_mutex_destroy(&pool.lock);
+  pthread_cond_destroy(&pool.done);
+
+  free(workers);
+  free(pool.jobs);
+
+  return status;
+}
@@ -0,0 +1,257 @@
+// Microbenchmark harness for the hot primitives of color.c, parse.c and
+// the ADT List. A synthetic map is generated in memory and each kernel is
+// timed over a number of repetitions (after a few warm-up repetitions).
+//
+// Usage: ./bench [<n_countries> [<degree> [<reps> [<warmup>]]]]
+//
+// - <n_countries> : number of countries in the synthetic map (default: 1000)
+// - <degree>      : average number of neighbours per country (default: 8)
+// - <reps>        : number of timed repetitions per kernel (default: 20)
+// - <warmup>      : number of untimed repetitions per kernel (default: 3)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "utilities.h"
+#include "constants.h"
+#include "ADT_List.h"
+#include "color.h"
+#include "parse.h"
+
+_Thread_local struct options options; // See utilities.h for the "struct options" definition
+
+static List *map;     // The synthetic map, as returned by read_map
+static FILE *map_txt; // Textual representation of the synthetic map
+static int n;         // Number of countries in the synthetic map
+
+static volatile long sink; // Keeps the compiler from discarding results
+
+struct kernel {
+  char *name;
+  void (*run)(int i); // Runs the kernel once, for the i-th call of a rep.
+  int calls;          // Number of calls per repetition
+  int items;          // Number of countries processed per call
+  bool silent;        // Kernel writes to stdout, which must be muted
+};
+
+// Lines are read with a 4096 byte buffer in read_map. A line takes 14
+// bytes ("nocolor C00042"), 7 more per neighbour (" C00042") and the
+// newline, so no country can have more than MAX_DEGREE neighbours
+
+#define MAX_DEGREE ((4096 - 16) / 7)
+
+// Writes a random map with n_countries countries and (roughly) the given
+// average degree to fp, using the same naming scheme as genmap (countries
+// that already have MAX_DEGREE neighbours aren't given any more)
+
+static void generate_map(FILE *fp, int n_countries, int degree) {
+  char *adj = calloc((size_t) n_countries * n_countries, sizeof(char));
+  int *n_neighbours = calloc(n_countries, sizeof(int));
+
+  if (adj == NULL || n_neighbours == NULL) terminate("bench: out of memory");
+
+  srand(1); // Same map on every run, so that results are comparable
+
+  // Each country picks degree/2 random neighbours, so that the average
+  // degree ends up being (roughly) equal to the requested one
+
+  for (int i = 0; i < n_countries; i++) {
+    for (int k = 0; k < degree / 2; k++) {
+      int j = rand() % n_countries;
+      if (j == i || adj[i * n_countries + j]) continue;
+
+      if (n_neighbours[i] == MAX_DEGREE || n_neighbours[j] == MAX_DEGREE)
+        continue;
+
+      adj[i * n_countries + j] = adj[j * n_countries + i] = 1;
+      n_neighbours[i]++;
+      n_neighbours[j]++;
+    }
+  }
+
+  for (int i = 0; i < n_countries; i++) {
+    fprintf(fp, "nocolor C%05d", i+1);
+
+    for (int j = 0; j < n_countries; j++)
+      if (adj[i * n_countries + j])
+        fprintf(fp, " C%05d", j+1);
+
+    fprintf(fp, "\n");
+  }
+
+  free(adj);
+  free(n_neighbours);
+}
+
+// Kernels (each one exercises a single primitive)
+
+static void k_list_get_first(int i) {
+  sink += (long) list_get_node(map[i], 2);
+}
+
+static void k_list_get_last(int i) {
+  sink += (long) list_get(map[i], list_size(map[i]) - 1);
+}
+
+static void k_get_name(int i) {
+  sink += (long) get_name(map, i);
+}
+
+static void k_find_country(int i) {
+  sink += find_country(map, get_name(map, (i * 7919) % n));
+}
+
+static void k_can_color(int i) {
+  sink += can_color(map, i, "red", false);
+}
+
+static void k_is_map_valid(int i) {
+  sink += is_map_valid(map);
+}
+
+static void k_read_map(int i) {
+  rewind(map_txt);
+
+  List *tmp = read_map(map_txt);
+  sink += options.n_countries;
+  cleanup(tmp);
+}
+
+static void k_map_print(int i) {
+  map_print(map);
+}
+
+// Returns the current time in nanoseconds
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// [Auxiliary] Function that compares two doubles (needed for qsort)
+
+static int cmp_double(const void *p, const void *q) {
+  double l = * (double *) p;
+  double r = * (double *) q;
+
+  return (l > r) - (l < r);
+}
+
+// Runs a kernel reps times (after warmup untimed runs) and reports the
+// median and best time per call, as well as the resulting throughput
+
+static void bench(struct kernel *k, int reps, int warmup) {
+  double *samples = malloc(sizeof(double) * reps);
+  if (samples == NULL) terminate("bench: out of memory");
+
+  int saved_stdout = -1;
+
+  if (k->silent) {
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+  }
+
+  for (int r = 0; r < warmup + reps; r++) {
+    double start = now_ns();
+
+    for (int i = 0; i < k->calls; i++)
+      k->run(i);
+
+    if (k->silent) fflush(stdout);
+
+    if (r >= warmup)
+      samples[r - warmup] = (now_ns() - start) / k->calls;
+  }
+
+  if (k->silent) {
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+  }
+
+  qsort(samples, reps, sizeof(double), cmp_double);
+
+  double median = samples[reps / 2];
+
+  printf("%-20s %14.1f %14.1f %14.1f %16.0f\n", k->name, median,
+         samples[0], 1e9 / median, 1e9 * k->items / median);
+
+  free(samples);
+}
+
+int main(int argc, char **argv) {
+  set_fatal_handler(exit_on_fatal);
+
+  n = 1000;
+
+  int degree = 8;
+  int reps   = 20;
+  int warmup = 3;
+
+  if (argc > 1) n      = atoi(argv[1]);
+  if (argc > 2) degree = atoi(argv[2]);
+  if (argc > 3) reps   = atoi(argv[3]);
+  if (argc > 4) warmup = atoi(argv[4]);
+
+  if (n <= 1 || n > MAX_COUNTRIES)
+    terminate("bench: invalid number of countries");
+
+  // The average degree has to fit in a line too (see MAX_DEGREE)
+
+  if (degree < 0 || degree >= n || degree > MAX_DEGREE)
+    terminate("bench: invalid degree");
+
+  if (reps <= 0 || warmup < 0)
+    terminate("bench: invalid number of repetitions");
+
+  if ((map_txt = tmpfile()) == NULL)
+    terminate("bench: cannot create temporary file");
+
+  generate_map(map_txt, n, degree);
+  rewind(map_txt);
+
+  map = read_map(map_txt);
+
+  if (!is_map_valid(map))
+    terminate("bench: generated map is invalid");
+
+  long edges = 0;
+  for (int i = 0; i < n; i++)
+    edges += neighbour_count(map, i);
+
+  printf("countries: %d, average degree: %.2f, reps: %d, warmup: %d\n\n",
+         n, (double) edges / n, reps, warmup);
+
+  printf("%-20s %14s %14s %14s %16s\n", "kernel", "ns/op (median)",
+         "ns/op (best)", "ops/s", "countries/s");
+
+  struct kernel kernels[] = {
+    {"list_get_node(2)", k_list_get_first, n, 1, false},
+    {"list_get(last)",   k_list_get_last,  n, 1, false},
+    {"get_name",         k_get_name,       n, 1, false},
+    {"find_country",     k_find_country,   n, 1, false},
+    {"can_color",        k_can_color,      n, 1, false},
+    {"is_map_valid",     k_is_map_valid,   1, n, false},
+    {"read_map+cleanup", k_read_map,       1, n, false},
+    {"map_print",        k_map_print,      1, n, true}
+  };
+
+  int n_kernels = sizeof(kernels) / sizeof(kernels[0]);
+
+  for (int i = 0; i < n_kernels; i++)
+    bench(&kernels[i], reps, warmup);
+
+  cleanup(map);
+  fclose(map_txt);
+
+  return 0;
+}
@@ -0,0 +1,162 @@
+// This file contains the implementation of the multi-word bitsets, as
+// described in bitset.h. Each bulk operation processes as many words as
+// possible with the widest vector registers available (4 words per AVX2
+// register, 2 words per SSE2 register), and the remaining words with
+// scalar code.
+//
+// The AVX2 population count uses the nibble lookup table method (each
+// byte is split into two nibbles, whose bit counts are looked up with a
+// byte shuffle), since there's no vector popcount instruction before
+// AVX-512. SSE2 doesn't have a byte shuffle, so it uses scalar popcounts.
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "bitset.h"
+
+// Sets the first n bits of a bitset of n_words words (and clears the rest)
+
+void bitset_fill(uint64_t *set, int n_words, int n) {
+  memset(set, 0, sizeof(uint64_t) * n_words);
+
+  for (int i = 0; i < n / 64; i++)
+    set[i] = ~(uint64_t) 0;
+
+  if (n % 64 != 0)
+    set[n / 64] = ((uint64_t) 1 << (n % 64)) - 1;
+}
+
+// dst = a | b
+
+void bitset_or(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+               int n_words) {
+  int i = 0;
+
+#if defined(__AVX2__)
+  for ( ; i + 4 <= n_words; i += 4) {
+    __m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *) (b + i));
+    _mm256_storeu_si256((__m256i *) (dst + i), _mm256_or_si256(va, vb));
+  }
+#elif defined(__SSE2__)
+  for ( ; i + 2 <= n_words; i += 2) {
+    __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+    _mm_storeu_si128((__m128i *) (dst + i), _mm_or_si128(va, vb));
+  }
+#endif
+
+  for ( ; i < n_words; i++)
+    dst[i] = a[i] | b[i];
+}
+
+// Returns true if at least one bit is set
+
+bool bitset_any(const uint64_t *set, int n_words) {
+  int i = 0;
+
+#if defined(__AVX2__)
+  for ( ; i + 4 <= n_words; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) (set + i));
+    if (!_mm256_testz_si256(v, v)) return true;
+  }
+#elif defined(__SSE2__)
+  for ( ; i + 2 <= n_words; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i *) (set + i));
+    __m128i zero = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+    if (_mm_movemask_epi8(zero) != 0xFFFF) return true;
+  }
+#endif
+
+  for ( ; i < n_words; i++)
+    if (set[i] != 0) return true;
+
+  return false;
+}
+
+#if defined(__AVX2__)
+
+// [Auxiliary] Returns the per-64-bit-lane bit counts of a vector
+
+static inline __m256i popcount_256(__m256i v) {
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                          1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3,
+                                          1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0F);
+
+  __m256i lo = _mm256_and_si256(v, low_mask);
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+
+  __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                   _mm256_shuffle_epi8(lookup, hi));
+
+  // Sum the byte counts of each 64-bit lane
+  return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+// [Auxiliary] Returns the sum of the four 64-bit lanes of a vector
+
+static inline int sum_256(__m256i v) {
+  return _mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1)
+       + _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3);
+}
+
+#endif
+
+// Returns the number of bits that are set
+
+int bitset_popcount(const uint64_t *set, int n_words) {
+  int count = 0, i = 0;
+
+#if defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+
+  for ( ; i + 4 <= n_words; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) (set + i));
+    acc = _mm256_add_epi64(acc, popcount_256(v));
+  }
+
+  count = sum_256(acc);
+#endif
+
+  for ( ; i < n_words; i++)
+    count += __builtin_popcountll(set[i]);
+
+  return count;
+}
+
+// Returns the index of the first set bit that's >= from (-1 if none)
+
+int bitset_next(const uint64_t *set, int n_words, int from) {
+  if (from < 0) from = 0;
+
+  int i = from >> 6;
+  if (i >= n_words) return -1;
+
+  // The first word is masked, so that the bits before "from" are ignored
+  uint64_t word = set[i] & (~(uint64_t) 0 << (from & 63));
+  if (word != 0) return (i << 6) + __builtin_ctzll(word);
+
+  // Skip over the words that are all zeros (a vector at a time)
+  for (i++; i < n_words; i++) {
+#if defined(__AVX2__)
+    while (i + 4 <= n_words) {
+      __m256i v = _mm256_loadu_si256((const __m256i *) (set + i));
+      if (!_mm256_testz_si256(v, v)) break;
+      i += 4;
+    }
+
+    if (i >= n_words) break;
+#endif
+
+    if (set[i] != 0) return (i << 6) + __builtin_ctzll(set[i]);
+  }
+
+  return -1;
+}
@@ -0,0 +1,166 @@
+// In this implementation, each cache entry is a small text file:
+//
+// mapcol-cache 1
+// <n_countries> <n_edges> <n_colors>
+// <color index of canonical vertex 0> <color index of vertex 1> ...
+//
+// Entries are written to a temporary file first, which is then renamed,
+// so that a concurrent reader (e.g. another batch worker, or another
+// mapcol process) never sees a half-written entry.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "utilities.h"
+#include "color.h"
+#include "graph.h"
+#include "palette.h"
+#include "cache.h"
+
+#define CACHE_VERSION 1
+
+// [Auxiliary] Returns the path of the cache entry for a key (the caller
+// has to free it)
+
+static char * entry_path(struct canon *key) {
+  size_t size = strlen(options.cache_dir) + 32;
+
+  char *path = malloc(size);
+  if (path == NULL) terminate("cache: out of memory");
+
+  snprintf(path, size, "%s/%016" PRIx64, options.cache_dir, key->hash);
+  return path;
+}
+
+// Returns the key under which the coloring of a (valid) map is cached,
+// or NULL if the map can't be cached (it's precolored with colors other
+// than the first n_colors). The key is destroyed with canon_destroy
+
+struct canon * cache_key(List *map, char **colors, int n_colors) {
+  struct graph *g = graph_build(map, colors, n_colors);
+  struct canon *key = NULL;
+
+  bool cacheable = true;
+
+  for (int i = 0; i < g->n_countries; i++)
+    if (g->colors[i] == -2)
+      cacheable = false;
+
+  if (cacheable) key = canon_create(g, n_colors);
+
+  graph_destroy(g);
+  return key;
+}
+
+// Looks up the coloring of a map in the cache. If there's one, it's used
+// to paint the uncolored countries of the map, and it's verified with
+// is_valid_coloring. Returns true if the map has been colored this way
+// (otherwise, the map is left as it was)
+
+bool cache_lookup(struct canon *key, List *map, char **colors, int max_colors,
+                  int n_colors) {
+  char *path = entry_path(key);
+  FILE *fp = fopen(path, "r");
+  free(path);
+
+  if (fp == NULL) return false; // Cache miss
+
+  // A truncated or corrupt entry is a cache miss, like a missing one (the
+  // arrays are sized from the key, never from the entry)
+
+  int version, n_entry, n_edges, n_entry_colors;
+
+  bool hit = fscanf(fp, "mapcol-cache %d %d %d %d", &version, &n_entry,
+                    &n_edges, &n_entry_colors) == 4
+          && version == CACHE_VERSION && n_entry == key->n_countries
+          && n_edges == key->n_edges && n_entry_colors == n_colors;
+
+  if (!hit) {
+    fclose(fp);
+    return false;
+  }
+
+  int n = key->n_countries;
+
+  int *stored = malloc(sizeof(int) * (n + 1));
+  bool *painted = calloc(n + 1, sizeof(bool));
+
+  if (stored == NULL || painted == NULL) terminate("cache: out of memory");
+
+  for (int k = 0; hit && k < n; k++)
+    hit = fscanf(fp, "%d", &stored[k]) == 1
+       && stored[k] >= 0 && stored[k] < n_colors;
+
+  fclose(fp);
+
+  // Non-isomorphic maps may share a hash (and the canonical order may not
+  // line up for highly symmetric maps), so the coloring has to be verified
+
+  if (hit) {
+    for (int k = 0; k < n; k++) {
+      int v = key->order[k];
+
+      if (uncolored(map, v)) {
+        paint_country(map, v, colors[stored[k]]);
+        painted[v] = true;
+      }
+    }
+
+    hit = is_valid_coloring(map, colors, max_colors, n_colors);
+
+    if (!hit)
+      for (int v = 0; v < n; v++)
+        if (painted[v]) unpaint_country(map, v);
+  }
+
+  free(stored);
+  free(painted);
+
+  return hit;
+}
+
+// Stores the coloring of a (fully colored) map in the cache. The map has
+// to be in the same order as when its key was computed
+
+void cache_store(struct canon *key, List *map, char **colors, int n_colors) {
+  mkdir(options.cache_dir, 0777); // It may already exist
+
+  char *path = entry_path(key);
+  char *temp = malloc(strlen(path) + 8);
+  if (temp == NULL) terminate("cache: out of memory");
+
+  sprintf(temp, "%s.XXXXXX", path);
+
+  int fd = mkstemp(temp);
+  FILE *fp = (fd != -1) ? fdopen(fd, "w") : NULL;
+
+  bool stored = (fp != NULL);
+
+  if (stored) {
+    fprintf(fp, "mapcol-cache %d\n%d %d %d\n", CACHE_VERSION,
+            key->n_countries, key->n_edges, n_colors);
+
+    for (int k = 0; k < key->n_countries; k++) {
+      char *color = get_color(map, key->order[k]);
+      fprintf(fp, "%d%c", palette_find(colors, n_colors, color),
+              (k == key->n_countries - 1) ? '\n' : ' ');
+    }
+
+    stored = !ferror(fp);
+    stored = (fclose(fp) == 0) && stored && rename(temp, path) == 0;
+  } else if (fd != -1) {
+    close(fd);
+  }
+
+  if (!stored) {
+    if (fd != -1) unlink(temp);
+    fprintf(stderr, "Cannot store the coloring in the cache (%s)\n", path);
+  }
+
+  free(temp);
+  free(path);
+}
@@ -0,0 +1,172 @@
+// This file contains the computation of the canonical form of a graph,
+// as described in canon.h.
+//
+// Color refinement alone doesn't always tell all the vertices apart
+// (e.g. in a cycle, every vertex ends up with the same label). To get a
+// canonical order of the vertices, the remaining ties are broken by
+// individualization: the first vertex of the first tied class gets a new
+// label, and the labels are refined again. Vertices that are tied after
+// refinement are usually symmetric to each other, so it rarely matters
+// which one is picked. After MAX_INDIVIDUALIZATIONS rounds, the remaining
+// ties are broken by vertex index, which is still deterministic for the
+// same input, but may differ for relabelings of it.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "canon.h"
+
+#define MAX_INDIVIDUALIZATIONS 64
+
+struct vertex {
+  uint64_t label;
+  int index;
+};
+
+// [Auxiliary] 64-bit mixing function (the finalizer of SplitMix64)
+
+static inline uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+
+  return x;
+}
+
+// [Auxiliary] Function that compares two vertices based on their labels,
+// and then on their indices (needed for qsort)
+
+static int compare_vertices(const void *p, const void *q) {
+  const struct vertex *l = p, *r = q;
+
+  if (l->label != r->label) return (l->label < r->label) ? -1 : 1;
+  return l->index - r->index;
+}
+
+// [Auxiliary] Sorts the vertices based on their labels. Returns the
+// number of distinct labels
+
+static int sort_vertices(uint64_t *labels, struct vertex *vertices, int n) {
+  for (int v = 0; v < n; v++) {
+    vertices[v].label = labels[v];
+    vertices[v].index = v;
+  }
+
+  qsort(vertices, n, sizeof(struct vertex), compare_vertices);
+
+  int classes = (n > 0);
+
+  for (int k = 1; k < n; k++)
+    if (vertices[k].label != vertices[k-1].label)
+      classes++;
+
+  return classes;
+}
+
+// [Auxiliary] Refines the labels until the number of distinct labels
+// (classes) stops growing. Returns the final number of classes
+
+static int refine(struct graph *g, uint64_t *labels, uint64_t *next,
+                  struct vertex *vertices, int classes) {
+  int n = g->n_countries;
+
+  while (classes < n) {
+
+    // The neighbours' labels are combined with commutative operations,
+    // so that the order of the neighbour lists doesn't matter
+
+    for (int v = 0; v < n; v++) {
+      uint64_t sum = 0, xor = 0;
+
+      for (int i = g->offsets[v]; i < g->offsets[v+1]; i++) {
+        uint64_t h = mix(labels[g->adj[i]]);
+
+        sum += h;
+        xor ^= mix(h);
+      }
+
+      next[v] = mix(labels[v] ^ mix(sum) ^ (xor * 0x9e3779b97f4a7c15ULL));
+    }
+
+    int next_classes = sort_vertices(next, vertices, n);
+    if (next_classes == classes) break; // The partition is stable
+
+    memcpy(labels, next, sizeof(uint64_t) * n);
+    classes = next_classes;
+  }
+
+  return classes;
+}
+
+// Returns the canonical form of a graph whose countries are colored with
+// indices among the first n_colors colors (see graph.h)
+
+struct canon * canon_create(struct graph *g, int n_colors) {
+  int n = g->n_countries;
+
+  struct canon *c = malloc(sizeof(*c));
+  if (c == NULL) terminate("canon_create: out of memory");
+
+  c->n_countries = n;
+  c->n_edges = g->offsets[n] / 2;
+  c->order = malloc(sizeof(int) * (n + 1));
+
+  uint64_t *labels = malloc(sizeof(uint64_t) * (n + 1));
+  uint64_t *next = malloc(sizeof(uint64_t) * (n + 1));
+  struct vertex *vertices = malloc(sizeof(struct vertex) * (n + 1));
+
+  if (c->order == NULL || labels == NULL || next == NULL || vertices == NULL)
+    terminate("canon_create: out of memory");
+
+  // The initial labels are made of the degrees and the precolors
+
+  for (int v = 0; v < n; v++)
+    labels[v] = mix(((uint64_t) graph_degree(g, v) << 32)
+                  | (uint32_t) (g->colors[v] + 2));
+
+  int classes = sort_vertices(labels, vertices, n);
+  classes = refine(g, labels, next, vertices, classes);
+
+  // The hash only depends on the sorted labels (and on the sizes)
+
+  c->hash = mix(mix(mix(n) ^ c->n_edges) ^ n_colors);
+
+  sort_vertices(labels, vertices, n);
+
+  for (int k = 0; k < n; k++)
+    c->hash = mix(c->hash ^ vertices[k].label);
+
+  // Break the remaining ties (see the top of this file)
+
+  for (int round = 0; classes < n && round < MAX_INDIVIDUALIZATIONS; round++) {
+    int k = 0;
+
+    while (vertices[k].label != vertices[k+1].label) k++;
+
+    labels[vertices[k].index] = mix(labels[vertices[k].index] + round + 1);
+
+    classes = sort_vertices(labels, vertices, n);
+    classes = refine(g, labels, next, vertices, classes);
+
+    sort_vertices(labels, vertices, n);
+  }
+
+  for (int k = 0; k < n; k++)
+    c->order[k] = vertices[k].index;
+
+  free(labels);
+  free(next);
+  free(vertices);
+
+  return c;
+}
+
+// Destroys a canonical form (memory deallocation)
+
+void canon_destroy(struct canon *c) {
+  free(c->order);
+  free(c);
+}
@@ -1,16 +1,43 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <float.h>
+#include <time.h>
 
 #include "color.h"
 #include "utilities.h"
 #include "constants.h"
+#include "graph.h"
+#include "names.h"
+#include "palette.h"
+#include "progress.h"
+#include "libmapcol.h"
 
 // Returns true if a map is valid, according to the format specified
-// in parse.c (rules A and B)
+// in parse.c (rules A, B and D)
 
 bool is_map_valid(List *map) {
 
+  // Check that no country has more than one line (rule D), with a hash
+  // table of the names seen so far
+
+  struct names *names = names_create();
+  if (names == NULL) terminate("is_map_valid: out of memory");
+
+  bool unique = true;
+
+  for (int country = 0; unique && country < options.n_countries; country++) {
+    int index = names_add(names, get_name(map, country));
+    if (index == -1) terminate("is_map_valid: out of memory");
+
+    unique = (index == country);
+  }
+
+  names_destroy(names);
+
+  if (!unique)
+    return false; // Rule D is not met, so the map is invalid
+
   // For each country, check if there exists a list in map for each of
   // its neighbours (rule A). If found, check if that list contains the
   // current country as a neighbour (neighbour of neighbour, rule B).
@@ -68,8 +95,14 @@ List * map_copy(List *map) {
 // Does this really need any documentation? :P
 
 void map_print(List *map) {
+  map_fprint(map, stdout);
+}
+
+// Prints a map to the given stream
+
+void map_fprint(List *map, FILE *fp) {
   for (int i = 0; i < options.n_countries; i++)
-    list_print(map[i]);
+    list_fprint(map[i], fp);
 }
 
 // Replaces "nocolor" with a valid color for a country in the map
@@ -178,46 +211,396 @@ void sort_map(List *map) {
   qsort((void *) map, options.n_countries, sizeof(List), comparator);
 }
 
+// Returns the integer form of a map, in which the colors of the countries
+// are looked up in the first n_colors entries of the colors array
+
+struct graph * graph_build(List *map, char **colors, int n_colors) {
+  int n = options.n_countries;
+
+  struct graph *g = malloc(sizeof(*g));
+  if (g == NULL) terminate("graph_build: out of memory");
+
+  g->n_countries = n;
+  g->offsets = malloc(sizeof(int) * (n + 1));
+  g->colors = malloc(sizeof(int) * (n + 1));
+
+  if (g->offsets == NULL || g->colors == NULL)
+    terminate("graph_build: out of memory");
+
+  // A hash table replaces the linear search of find_country
+
+  struct names *names = names_create();
+  if (names == NULL) terminate("graph_build: out of memory");
+
+  g->offsets[0] = 0;
+
+  for (int i = 0; i < n; i++) {
+    if (names_add(names, get_name(map, i)) != i)
+      terminate("graph_build: duplicate country");
+
+    g->offsets[i+1] = g->offsets[i] + neighbour_count(map, i);
+
+    char *color = get_color(map, i);
+
+    if (color == NULL)
+      g->colors[i] = -1;
+    else if ((g->colors[i] = palette_find(colors, n_colors, color)) == -1)
+      g->colors[i] = -2;
+  }
+
+  g->adj = malloc(sizeof(int) * (g->offsets[n] + 1));
+  if (g->adj == NULL) terminate("graph_build: out of memory");
+
+  for (int i = 0; i < n; i++) {
+    int *neighbour = &g->adj[g->offsets[i]];
+
+    listNode curr = list_get_node(map[i], 2);
+
+    while (curr != list_end(map[i])) {
+      if ((*neighbour++ = names_find(names, list_access(map[i], curr))) == -1)
+        terminate("graph_build: unknown country");
+
+      curr = list_next(map[i], curr);
+    }
+  }
+
+  names_destroy(names);
+  return g;
+}
+
+// [Auxiliary] Returns a map handle (see libmapcol.h) with the countries,
+// borders and colors of a map, in which a color that isn't among the first
+// n_colors entries of the colors array becomes a precolor that no other
+// country can have. A country that lists itself as a neighbour doesn't
+// border itself (the search has always ignored that)
+
+static struct mapcol * map_handle(List *map, char **colors, int n_colors) {
+  int n = options.n_countries, max_neighbours = 0;
+
+  struct mapcol *m = mapcol_create();
+  if (m == NULL) terminate("color_map: out of memory");
+
+  for (int i = 0; i < n; i++) {
+    int index = mapcol_country(m, get_name(map, i));
+
+    if (index == -1) terminate((char *) mapcol_error(m));
+    if (index != i) terminate("color_map: duplicate country");
+
+    if (neighbour_count(map, i) > max_neighbours)
+      max_neighbours = neighbour_count(map, i);
+  }
+
+  const char **neighbours = malloc(sizeof(char *) * (max_neighbours + 1));
+  if (neighbours == NULL) terminate("color_map: out of memory");
+
+  for (int i = 0; i < n; i++) {
+    int count = 0;
+
+    // First neighbouring country starts at the third position
+    listNode curr = list_get_node(map[i], 2);
+
+    while (curr != list_end(map[i])) {
+      char *name = list_access(map[i], curr);
+      if (strcmp(name, get_name(map, i)) != 0) neighbours[count++] = name;
+
+      curr = list_next(map[i], curr);
+    }
+
+    if (mapcol_add(m, get_name(map, i), neighbours, count) == -1)
+      terminate((char *) mapcol_error(m));
+
+    char *color = get_color(map, i);
+
+    if (color != NULL) {
+      int index = palette_find(colors, n_colors, color);
+      mapcol_precolor(m, i, (index != -1) ? index : n_colors);
+    }
+  }
+
+  free(neighbours);
+
+  if (mapcol_size(m) != n) terminate("color_map: unknown country");
+
+  return m;
+}
+
+// State of the (optional) deadline of color_map, and the handle of the map
+// of its last call, which keeps what the call found out (the state is per
+// thread, so that maps can be colored concurrently)
+
+static _Thread_local double deadline = 0;          // Absolute deadline (0: none)
+static _Thread_local struct mapcol *last = NULL;   // Handle of the last call
+static _Thread_local enum mapcol_status last_status;
+static _Thread_local char **last_colors;           // Colors that "last" refers to
+
+// [Auxiliary] Returns the time elapsed since an arbitrary fixed point (in
+// seconds)
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// [Auxiliary] Returns the timeout of a libmapcol call that ends at the
+// deadline (0 if there's none). The deadline may have passed already (it
+// covers the whole run), in which case the call gives up right away
+
+static double time_left(void) {
+  if (deadline == 0) return 0;
+
+  double left = deadline - now();
+  return (left > 0) ? left : DBL_MIN;
+}
+
+// Makes color_map, count_colorings and enumerate_colorings give up once
+// the given number of seconds has passed (a non-positive number of seconds
+// means that there's no deadline)
+
+void set_deadline(double seconds) {
+  deadline = (seconds > 0) ? now() + seconds : 0;
+}
+
+// Returns true if the last call to color_map gave up because the
+// deadline had passed
+
+bool deadline_expired(void) {
+  return last != NULL && last_status == MAPCOL_TIMEOUT;
+}
+
+// Paints the map with the deepest partial coloring reached by the last
+// call to color_map (the countries it didn't get to are left uncolored)
+
+void restore_best_coloring(List *map) {
+  if (!deadline_expired()) return;
+
+  const int *color = mapcol_colors(last);
+
+  for (int i = 0; i < options.n_countries; i++)
+    if (uncolored(map, i) && color[i] >= 0)
+      paint_country(map, i, last_colors[color[i]]);
+}
+
+// Stores in *before and *after the bandwidth of the numbering of the
+// countries (the largest difference between the indices of two neighbours)
+// before and after the last call to color_map renumbered them. Returns
+// false if the countries weren't renumbered (see --renumber)
+
+bool renumber_bandwidth(int *before, int *after) {
+  if (last == NULL) return false;
+
+  *before = mapcol_report(last)->bandwidth_before;
+  *after = mapcol_report(last)->bandwidth_after;
+
+  return *before != -1;
+}
+
+// Returns the search statistics of the last call to color_map (NULL if
+// there's none)
+
+const struct mapcol_stats * color_map_stats(void) {
+  return (last != NULL) ? mapcol_stats(last) : NULL;
+}
+
+// Releases what the last call to color_map has kept for the functions
+// above (the next call does it too)
+
+void color_map_free(void) {
+  mapcol_destroy(last);
+  last = NULL;
+}
+
+// [Auxiliary] Prints the outcome of presolve to stderr (for --stats): how
+// many countries it colored, or the country that has no colors left
+
+static void report_presolve(List *map, const struct mapcol_report *r) {
+  if (r->empty != -1) {
+    fprintf(stderr, "[presolve] infeasible: %s can't take any color\n",
+            get_name(map, r->empty));
+    return;
+  }
+
+  fprintf(stderr, "[presolve] %d precolored, %d forced, %d left to search\n",
+          r->n_precolored, r->n_forced, r->n_searched);
+}
+
+// [Auxiliary] Prints the outcome of a planarity test to stderr (for
+// --stats), including the Kuratowski subgraph of a non-planar map if it
+// was extracted (--witness)
+
+static void report_planarity(List *map, const struct mapcol_report *r) {
+  if (r->planar) {
+    fprintf(stderr, "[planarity] planar (%d countries, %d borders, %d faces)\n",
+            options.n_countries, r->n_borders, r->n_faces);
+    return;
+  }
+
+  if (r->witness == NULL) {
+    fprintf(stderr, "[planarity] not planar\n");
+    return;
+  }
+
+  fprintf(stderr, "[planarity] not planar (subdivision of %s:",
+          r->k5 ? "K5" : "K3,3");
+
+  for (int i = 0; i < r->n_witness; i++)
+    fprintf(stderr, " %s-%s", get_name(map, r->witness[2*i]),
+            get_name(map, r->witness[2*i+1]));
+
+  fprintf(stderr, ")\n");
+}
+
+// [Auxiliary] Prints what a solve found out on the way to stderr (for
+// --stats): the outcomes of the planarity test, of the tree decomposition
+// and of presolve, for the ones that ran (colored is its result)
+
+static void report_solve(List *map, const struct mapcol_report *r,
+                         bool colored) {
+  if (r->planar != -1) report_planarity(map, r);
+
+  if (r->width != -1 && !r->searched)
+    fprintf(stderr, "[treedec] width %d: %s by dynamic programming\n",
+            r->width, colored ? "colored" : "proved uncolorable");
+  else if (r->width != -1)
+    fprintf(stderr, "[treedec] width above %d, searching instead\n",
+            r->width - 1);
+
+  if (r->searched) report_presolve(map, r);
+}
+
 // Colors a map with at most n colors so that two neighbouring countries
 // have different colors. Returns true on success and false on failure
+// (or if the deadline set with set_deadline has passed)
 
 bool color_map(List *map, char **colors, int n_colors) {
+  color_map_free();
 
-  // The algorithm works as follows:
-  //
-  // for each country:
-  //   1. If it hasn't already been colored, color it with the first
-  //      available color in the colors array. Otherwise, continue to
-  //      the next country.
-  //
-  //   2. If such a color has been found (meaning that the country can
-  //      be colored), and if, after it's been colored, there are no more
-  //      countries to color, we're done and the map has been completely
-  //      colored. Otherwise (if not all countries have been colored),
-  //      recursively color the rest of the map (i.e. jump to "for each
-  //      country").
-  //
-  //   3. Otherwise, backtrack to the last country colored and choose a
-  //      different color for it.
+  last = map_handle(map, colors, n_colors);
+  last_colors = colors;
 
-  for (int country = 0; country < options.n_countries; country++) {
-    if (uncolored(map, country)) {
-      for (int curr_clr = 0; curr_clr < n_colors; curr_clr++) {
-        if (can_color(map, country, colors[curr_clr], false)) {
-          paint_country(map, country, colors[curr_clr]);
-
-          if (color_map(map, colors, n_colors) == false)
-            unpaint_country(map, country); // Backtrack
-          else
-            return true; // Map can be colored
-        }
-      }
+  struct mapcol_options o;
+  mapcol_default_options(&o);
 
-      return false; // Current country couldn't be colored
-    }
+  o.n_colors = n_colors;
+  o.seed = options.seed;
+  o.renumber = options.renumber;
+  o.witness = options.stats && options.witness && !options.batch;
+
+  if (options.stats && !options.batch) o.progress = progress_check;
+
+  o.timeout = time_left();
+
+  last_status = mapcol_solve(last, &o);
+
+  if (last_status == MAPCOL_ERROR || last_status == MAPCOL_INVALID)
+    terminate((char *) mapcol_error(last));
+
+  bool colored = (last_status == MAPCOL_OK);
+
+  if (options.stats && !options.batch)
+    report_solve(map, mapcol_report(last), colored);
+
+  if (colored) {
+    const int *color = mapcol_colors(last);
+
+    for (int i = 0; i < options.n_countries; i++)
+      if (uncolored(map, i)) paint_country(map, i, colors[color[i]]);
   }
 
-  return true; // All countries are colored
+  return colored;
+}
+
+// [Auxiliary] Prints the width of the tree decomposition of a map that
+// the colorings are counted or enumerated with (for --stats)
+
+static void report_width(const struct mapcol_report *r) {
+  if (!options.stats || options.batch) return;
+
+  if (!r->searched)
+    fprintf(stderr, "[treedec] width %d\n", r->width);
+  else
+    fprintf(stderr, "[treedec] width above %d, backtracking instead\n",
+            r->width - 1);
+}
+
+// Counts the colorings of a map with n colors that leave its precolored
+// countries as they are. Returns the count as a decimal number (which the
+// caller has to free), or NULL if the deadline set with set_deadline
+// passed first
+
+char * count_colorings(List *map, char **colors, int n_colors) {
+  struct mapcol *m = map_handle(map, colors, n_colors);
+  const char *count;
+
+  enum mapcol_status status = mapcol_count(m, n_colors, time_left(), &count);
+
+  if (status == MAPCOL_ERROR || status == MAPCOL_INVALID)
+    terminate((char *) mapcol_error(m));
+
+  report_width(mapcol_report(m));
+
+  if (status == MAPCOL_TIMEOUT) {
+    mapcol_destroy(m);
+    return NULL;
+  }
+
+  char *copy = malloc(strlen(count) + 1);
+  if (copy == NULL) terminate("count_colorings: out of memory");
+
+  strcpy(copy, count);
+
+  mapcol_destroy(m);
+  return copy;
+}
+
+struct enumeration {
+  List *map;
+  char **colors;
+  bool *uncolored; // Countries that the colorings color
+};
+
+// [Auxiliary] Paints a map with one of its colorings and prints it
+
+static void print_coloring(const int *color, void *arg) {
+  struct enumeration *e = arg;
+
+  for (int i = 0; i < options.n_countries; i++)
+    if (e->uncolored[i]) paint_country(e->map, i, e->colors[color[i]]);
+
+  map_print(e->map);
+  printf("\n");
+}
+
+// Prints every coloring of a map with n colors that leaves its precolored
+// countries as they are, as soon as it's found (each one as a map, followed
+// by an empty line). Returns the number of colorings, or -1 if the deadline
+// set with set_deadline passed before they were all printed
+
+long enumerate_colorings(List *map, char **colors, int n_colors) {
+  struct mapcol *m = map_handle(map, colors, n_colors);
+  struct enumeration e = {map, colors, NULL};
+
+  e.uncolored = malloc(sizeof(bool) * (options.n_countries + 1));
+  if (e.uncolored == NULL) terminate("enumerate_colorings: out of memory");
+
+  for (int i = 0; i < options.n_countries; i++)
+    e.uncolored[i] = uncolored(map, i);
+
+  long found = mapcol_enumerate(m, n_colors, time_left(), print_coloring, &e);
+  if (found == -1) terminate((char *) mapcol_error(m));
+
+  report_width(mapcol_report(m));
+  if (mapcol_report(m)->cut_short) found = -1;
+
+  // The map is left as it was
+
+  for (int i = 0; i < options.n_countries; i++)
+    if (e.uncolored[i]) unpaint_country(map, i);
+
+  free(e.uncolored);
+  mapcol_destroy(m);
+  return found;
 }
 
 // Returns true if a map is colored with only the first n_clrs colors
@@ -232,9 +615,12 @@ bool is_valid_coloring(List *map, char *clrs[], int max_clrs, int n_clrs) {
     if (!can_color(map, i, curr_clr, true))
       return false; // invalid coloring: two neighbours have the same color
 
-    if (n_clrs < max_clrs-1 && !strcmp(curr_clr, clrs[n_clrs])) {
+    // The color has to be one of the first n_clrs ones (a color further
+    // down the palette, or one that isn't in it at all, is an extra one)
+
+    if (palette_find(clrs, n_clrs, curr_clr) == -1) {
       printf("More than %d colors used\n", n_clrs);
-      return false; // invalid coloring: n_clrs+1 colors used instead of n_clrs
+      return false; // invalid coloring: more than n_clrs colors used
     }
   }
 
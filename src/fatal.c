@@ -0,0 +1,34 @@
+// This file contains the handling of fatal errors, as described in fatal.h
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "fatal.h"
+
+_Thread_local jmp_buf *fatal_recovery = NULL;
+_Thread_local char *fatal_error = NULL;
+
+static void (*fatal_handler)(char *msg) = NULL;
+
+// Sets the function that handles the fatal errors outside of the library
+// calls (it must not return)
+
+void set_fatal_handler(void (*handler)(char *msg)) {
+  fatal_handler = handler;
+}
+
+// Reports a fatal error: it's returned to the recovery point of the
+// current thread, if there's one, and it's passed to the handler otherwise
+// (without a handler, it's printed and the process aborts)
+
+void terminate(char *msg) {
+  if (fatal_recovery != NULL) {
+    fatal_error = msg;
+    longjmp(*fatal_recovery, 1);
+  }
+
+  if (fatal_handler != NULL) fatal_handler(msg);
+
+  fprintf(stderr, "%s\n", msg);
+  abort();
+}
@@ -4,8 +4,7 @@
 #include <stdio.h>
 #include <time.h>
 
-char *colors[] = {"red", "green", "blue", "yellow", "orange",
-                  "violet", "cyan", "pink", "brown", "grey"};
+#include "palette.h"
 
 int main(int argc, char **argv) {
   int n_countries;     // Number of countries in the graph
@@ -14,7 +13,8 @@ int main(int argc, char **argv) {
   int colornum = 4;    // Number of colors with which graph can be colored
 
   long seed = time(NULL);
-  char *color, **neighb;
+  int *color;
+  char **neighb;
 
   if (argc == 1) {
     fprintf(stderr, "%s: Wrong usage\n", argv[0]);
@@ -28,15 +28,20 @@ int main(int argc, char **argv) {
   if (argc > 4) seed = atoi(argv[4]);
   if (argc > 5) colornum = atoi(argv[5]);
 
-  if (colornum > (int) sizeof(colors)) {
-    fprintf(stderr, "%s: Too many colors\n", argv[0]);
+  // Colors beyond the default ones get generated names (see palette.h)
+
+  int n_palette;
+  char **colors = palette_create(colornum, NULL, &n_palette);
+
+  if (colornum <= 0 || colors == NULL) {
+    fprintf(stderr, "%s: Invalid number of colors\n", argv[0]);
     exit(EXIT_FAILURE);
   }
 
   srand((unsigned) seed);
 
   // Color matrix for the countries
-  color = malloc(n_countries * sizeof(char));
+  color = malloc(n_countries * sizeof(int));
 
   // Reserve space for the 2-D triangular matrix to hold countries' borders
   neighb = malloc(n_countries * sizeof(char *));
@@ -95,5 +100,7 @@ int main(int argc, char **argv) {
   free(neighb);
   free(color);
 
+  palette_destroy(colors, n_palette);
+
   return 0;
 }
@@ -0,0 +1,371 @@
+#include <stdlib.h>
+
+#include "fatal.h"
+#include "graph.h"
+
+// Arcs of a graph that's being built (see graph_from_arcs), grouped by the
+// vertex they leave and by the vertex they enter
+
+struct arcs {
+  int *out_offsets;  // Heads of the arcs that leave v: out[out_offsets[v]] ...
+  int *out;
+  int *in_offsets;   // Tails of the arcs that enter v: in[in_offsets[v]] ...
+  int *in;
+  int *balance;      // Scratch space of unmatched (all zeros between calls)
+};
+
+// [Auxiliary] Stores in dst (unless it's NULL) the tails of the arcs that
+// enter vertex v and have no reverse arc (a tail that has k more arcs to v
+// than v has to it appears k times), in the order of the arcs. Returns
+// their number
+
+static int unmatched(struct arcs *a, int v, int *dst) {
+  int count = 0;
+
+  for (int i = a->out_offsets[v]; i < a->out_offsets[v+1]; i++)
+    a->balance[a->out[i]]++;
+
+  for (int i = a->in_offsets[v]; i < a->in_offsets[v+1]; i++) {
+    int u = a->in[i];
+
+    if (a->balance[u]-- > 0) continue; // Matched by an arc from v to u
+
+    if (dst != NULL) dst[count] = u;
+    count++;
+  }
+
+  // Every vertex whose balance changed is a neighbour of v either way
+
+  for (int i = a->out_offsets[v]; i < a->out_offsets[v+1]; i++)
+    a->balance[a->out[i]] = 0;
+
+  for (int i = a->in_offsets[v]; i < a->in_offsets[v+1]; i++)
+    a->balance[a->in[i]] = 0;
+
+  return count;
+}
+
+// [Auxiliary] Groups n_arcs arcs (end[i], other[i]) by their end: the
+// other ends of the arcs at vertex v are stored in grouped[offsets[v]] ...
+// grouped[offsets[v+1]-1], in the order of the arcs (offsets has n + 2
+// entries, all zeros)
+
+static void group_arcs(int n, int n_arcs, const int *end, const int *other,
+                       int *offsets, int *grouped) {
+
+  // Count the arcs at each vertex (in offsets[v+2], so that the running
+  // sums below leave the start of each vertex in offsets[v+1])
+
+  for (int i = 0; i < n_arcs; i++)
+    offsets[end[i] + 2]++;
+
+  for (int v = 0; v < n; v++)
+    offsets[v+2] += offsets[v+1];
+
+  for (int i = 0; i < n_arcs; i++)
+    grouped[offsets[end[i] + 1]++] = other[i];
+}
+
+// Returns a graph of n vertices (all of them uncolored), in which the
+// neighbours of each vertex are the heads of the n_arcs arcs (from[i],
+// to[i]) that leave it, in the order of the arcs. An arc that has no
+// reverse arc gets one, after the other neighbours of its head (so an
+// edge can be given as a single arc, or as an arc each way)
+
+struct graph * graph_from_arcs(int n, int n_arcs, const int *from,
+                               const int *to) {
+  struct graph *g = malloc(sizeof(*g));
+  if (g == NULL) terminate("graph_from_arcs: out of memory");
+
+  struct arcs a;
+
+  a.out_offsets = calloc(n + 2, sizeof(int));
+  a.out = malloc(sizeof(int) * (n_arcs + 1));
+  a.in_offsets = calloc(n + 2, sizeof(int));
+  a.in = malloc(sizeof(int) * (n_arcs + 1));
+  a.balance = calloc(n + 1, sizeof(int));
+
+  g->n_countries = n;
+  g->offsets = malloc(sizeof(int) * (n + 1));
+  g->colors = malloc(sizeof(int) * (n + 1));
+
+  if (a.out_offsets == NULL || a.out == NULL || a.in_offsets == NULL
+   || a.in == NULL || a.balance == NULL || g->offsets == NULL
+   || g->colors == NULL)
+    terminate("graph_from_arcs: out of memory");
+
+  group_arcs(n, n_arcs, from, to, a.out_offsets, a.out);
+  group_arcs(n, n_arcs, to, from, a.in_offsets, a.in);
+
+  g->offsets[0] = 0;
+
+  for (int v = 0; v < n; v++) {
+    g->offsets[v+1] = g->offsets[v] + (a.out_offsets[v+1] - a.out_offsets[v])
+                    + unmatched(&a, v, NULL);
+    g->colors[v] = -1;
+  }
+
+  g->adj = malloc(sizeof(int) * (g->offsets[n] + 1));
+  if (g->adj == NULL) terminate("graph_from_arcs: out of memory");
+
+  for (int v = 0; v < n; v++) {
+    int *neighbour = &g->adj[g->offsets[v]];
+
+    for (int i = a.out_offsets[v]; i < a.out_offsets[v+1]; i++)
+      *neighbour++ = a.out[i];
+
+    unmatched(&a, v, neighbour);
+  }
+
+  free(a.out_offsets);
+  free(a.out);
+  free(a.in_offsets);
+  free(a.in);
+  free(a.balance);
+
+  return g;
+}
+
+// Stores the distinct edges of a graph (self-loops and repeated neighbours
+// are ignored) in two newly allocated arrays: edge i joins vertices
+// (*from)[i] < (*to)[i]. Returns the number of edges
+
+int graph_edges(struct graph *g, int **from, int **to) {
+  int n = g->n_countries;
+
+  *from = malloc(sizeof(int) * (g->offsets[n] + 1));
+  *to = malloc(sizeof(int) * (g->offsets[n] + 1));
+
+  int *seen = malloc(sizeof(int) * (n + 1)); // seen[u] == v: v-u was added
+
+  if (*from == NULL || *to == NULL || seen == NULL)
+    terminate("graph_edges: out of memory");
+
+  for (int v = 0; v < n; v++)
+    seen[v] = -1;
+
+  int m = 0;
+
+  for (int v = 0; v < n; v++)
+    for (int i = g->offsets[v]; i < g->offsets[v+1]; i++) {
+      int u = g->adj[i];
+      if (u <= v || seen[u] == v) continue;
+
+      seen[u] = v;
+      (*from)[m] = v;
+      (*to)[m++] = u;
+    }
+
+  free(seen);
+  return m;
+}
+
+// Number of times the starting vertex of each component is moved to a
+// vertex further away from it, while searching for a pseudo-peripheral
+// vertex (George-Liu)
+
+#define PERIPHERAL_ROUNDS 4
+
+// [Auxiliary] Function that compares two long integers (needed for qsort)
+
+static int compare_keys(const void *p, const void *q) {
+  long long l = * (const long long *) p;
+  long long r = * (const long long *) q;
+
+  return (l > r) - (l < r);
+}
+
+// [Auxiliary] Function that compares two integers (needed for qsort)
+
+static int compare_ints(const void *p, const void *q) {
+  int l = * (const int *) p;
+  int r = * (const int *) q;
+
+  return (l > r) - (l < r);
+}
+
+// [Auxiliary] Sorts an array of vertices by degree (ties are broken by
+// vertex number), using keys as scratch space
+
+static void sort_by_degree(struct graph *g, int *vertices, int count,
+                           long long *keys) {
+  int n = g->n_countries;
+
+  for (int i = 0; i < count; i++)
+    keys[i] = (long long) graph_degree(g, vertices[i]) * n + vertices[i];
+
+  qsort(keys, count, sizeof(long long), compare_keys);
+
+  for (int i = 0; i < count; i++)
+    vertices[i] = keys[i] % n;
+}
+
+// [Auxiliary] Breadth-first search from root, over the vertices whose
+// level is -1. The visited vertices are stored in queue, in Cuthill-McKee
+// order (the unvisited neighbours of each vertex in increasing degree), and
+// their distance from root is stored in level. Returns the number of
+// visited vertices
+
+static int bfs(struct graph *g, int root, int *level, int *queue,
+               long long *keys) {
+  int head = 0, tail = 0;
+
+  level[root] = 0;
+  queue[tail++] = root;
+
+  while (head < tail) {
+    int v = queue[head++];
+    int first = tail;
+
+    for (int i = g->offsets[v]; i < g->offsets[v+1]; i++) {
+      int u = g->adj[i];
+
+      if (level[u] == -1) {
+        level[u] = level[v] + 1;
+        queue[tail++] = u;
+      }
+    }
+
+    sort_by_degree(g, &queue[first], tail - first, keys);
+  }
+
+  return tail;
+}
+
+// Returns a locality-improving numbering of the vertices of a graph, as
+// an array in which perm[v] is the new number of vertex v (reverse
+// Cuthill-McKee: neighbouring vertices get numbers that are close to each
+// other, so that they're also close to each other in memory)
+
+int * graph_rcm(struct graph *g) {
+  int n = g->n_countries;
+
+  int *perm = malloc(sizeof(int) * (n + 1));
+  int *level = malloc(sizeof(int) * (n + 1));
+  int *queue = malloc(sizeof(int) * (n + 1));
+  int *roots = malloc(sizeof(int) * (n + 1));
+  long long *keys = malloc(sizeof(long long) * (n + 1));
+
+  if (perm == NULL || level == NULL || queue == NULL || roots == NULL
+   || keys == NULL)
+    terminate("graph_rcm: out of memory");
+
+  // Each component is numbered starting from a vertex of minimum degree
+
+  for (int v = 0; v < n; v++) {
+    level[v] = -1;
+    roots[v] = v;
+  }
+
+  sort_by_degree(g, roots, n, keys);
+
+  int numbered = 0;
+
+  for (int r = 0; r < n; r++) {
+    int root = roots[r];
+    if (level[root] != -1) continue; // Its component is already numbered
+
+    int count = bfs(g, root, level, queue, keys);
+
+    // Move the root to a vertex of minimum degree in the last level, for
+    // as long as that makes the component "deeper" (this leads to narrower
+    // levels, and therefore to a smaller bandwidth)
+
+    for (int round = 0; round < PERIPHERAL_ROUNDS; round++) {
+      int depth = level[queue[count-1]];
+      int candidate = queue[count-1];
+
+      for (int i = count - 1; i >= 0 && level[queue[i]] == depth; i--)
+        if (graph_degree(g, queue[i]) <= graph_degree(g, candidate))
+          candidate = queue[i];
+
+      if (candidate == root) break;
+
+      for (int i = 0; i < count; i++)
+        level[queue[i]] = -1;
+
+      bfs(g, candidate, level, queue, keys);
+      root = candidate;
+
+      if (level[queue[count-1]] <= depth) break;
+    }
+
+    // The Cuthill-McKee order of all the components is reversed
+
+    for (int i = 0; i < count; i++)
+      perm[queue[i]] = n - 1 - numbered++;
+  }
+
+  free(level);
+  free(queue);
+  free(roots);
+  free(keys);
+
+  return perm;
+}
+
+// Returns a copy of a graph in which vertex v has become vertex perm[v]
+
+struct graph * graph_renumber(struct graph *g, int *perm) {
+  int n = g->n_countries;
+
+  struct graph *h = malloc(sizeof(*h));
+  if (h == NULL) terminate("graph_renumber: out of memory");
+
+  h->n_countries = n;
+  h->offsets = malloc(sizeof(int) * (n + 1));
+  h->colors = malloc(sizeof(int) * (n + 1));
+  h->adj = malloc(sizeof(int) * (g->offsets[n] + 1));
+
+  int *inverse = malloc(sizeof(int) * (n + 1));
+
+  if (h->offsets == NULL || h->colors == NULL || h->adj == NULL
+   || inverse == NULL)
+    terminate("graph_renumber: out of memory");
+
+  for (int v = 0; v < n; v++)
+    inverse[perm[v]] = v;
+
+  h->offsets[0] = 0;
+
+  for (int k = 0; k < n; k++) {
+    int v = inverse[k];
+    int *neighbour = &h->adj[h->offsets[k]];
+
+    h->offsets[k+1] = h->offsets[k] + graph_degree(g, v);
+    h->colors[k] = g->colors[v];
+
+    for (int i = g->offsets[v]; i < g->offsets[v+1]; i++)
+      *neighbour++ = perm[g->adj[i]];
+
+    // Neighbours are visited in memory order
+    qsort(&h->adj[h->offsets[k]], graph_degree(h, k), sizeof(int),
+          compare_ints);
+  }
+
+  free(inverse);
+  return h;
+}
+
+// Returns the bandwidth of a graph: the largest difference between the
+// numbers of two neighbouring vertices
+
+int graph_bandwidth(struct graph *g) {
+  int bandwidth = 0;
+
+  for (int v = 0; v < g->n_countries; v++)
+    for (int i = g->offsets[v]; i < g->offsets[v+1]; i++)
+      if (abs(g->adj[i] - v) > bandwidth)
+        bandwidth = abs(g->adj[i] - v);
+
+  return bandwidth;
+}
+
+// Destroys a graph (memory deallocation)
+
+void graph_destroy(struct graph *g) {
+  free(g->offsets);
+  free(g->adj);
+  free(g->colors);
+  free(g);
+}
@@ -0,0 +1,593 @@
+// This file contains the implementation of libmapcol, as described in
+// libmapcol.h. A handle keeps the borders of its map as a list of arcs (a
+// country listing a neighbour), which becomes the integer form of the map
+// (see graph.h) whenever it's solved, so that adding countries and borders
+// one by one stays cheap.
+//
+// The modules of the solver report fatal errors through terminate() (see
+// fatal.h), so every call that may run into one sets a recovery point
+// first (ENTER), and clears it before it returns (LEAVE). What a call
+// allocates on the way (the integer form of the map, and the solve) is
+// kept in the handle, so that it can be released if the call fails.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fatal.h"
+#include "stats.h"
+#include "graph.h"
+#include "names.h"
+#include "solve.h"
+#include "treedec.h"
+#include "libmapcol.h"
+
+struct mapcol {
+  int n_countries;
+  int capacity;        // Size of the arrays of the countries
+  int *precolor;       // Precolor of each country (-1: none)
+  int *colors;         // Colors found by the last solve
+  int *from, *to;      // Arcs: country from[i] borders country to[i]
+  int n_arcs;
+  int arc_capacity;    // Size of the arrays of the arcs
+  struct names *names; // Names of the countries (NULL: added by index)
+  char *count;         // Result of the last count (or NULL)
+  const char *error;   // Last error (or NULL)
+
+  struct mapcol_stats stats;   // Statistics of the last solve, whose
+  long *histogram;             // backtracks_at array is this one
+  struct mapcol_report report; // Outcome of the last solve or count, whose
+  int *witness;                // witness array is this one
+
+  // Progress callback of the current solve (see mapcol_options)
+
+  void (*progress)(const struct mapcol_stats *stats, void *arg);
+  void *progress_arg;
+
+  struct graph *graph; // Integer form of the map during a call (or NULL)
+  struct solve solve;  // Solve during a call to mapcol_solve
+};
+
+// [Auxiliary] Releases what a call on map m has allocated on the way
+
+static void release(struct mapcol *m) {
+  if (m->graph != NULL) graph_destroy(m->graph);
+  m->graph = NULL;
+
+  solve_free(&m->solve);
+  solve_init(&m->solve, 0);
+
+  stats_free();
+}
+
+// [Auxiliary] Sets the recovery point of a call on map m: if terminate()
+// is called before LEAVE, what the call has allocated is released, and it
+// returns on_error, with the error of m set (the recovery point of an
+// enclosing call is restored either way)
+
+#define ENTER(m, on_error)                                   \
+  jmp_buf recovery, *outer = fatal_recovery;                 \
+  if (setjmp(recovery)) {                                    \
+    fatal_recovery = outer;                                  \
+    release(m);                                              \
+    (m)->error = fatal_error;                                \
+    return on_error;                                         \
+  }                                                          \
+  fatal_recovery = &recovery
+
+#define LEAVE() fatal_recovery = outer
+
+// [Auxiliary] Returns an array of count elements of the given size, which
+// replaces p (its contents are kept)
+
+static void * resize(void *p, size_t count, size_t size) {
+  p = realloc(p, count * size + 1);
+  if (p == NULL) terminate("libmapcol: out of memory");
+
+  return p;
+}
+
+// [Auxiliary] Makes room for at least one more country in a map
+
+static void grow_countries(struct mapcol *m) {
+  if (m->n_countries < m->capacity) return;
+
+  m->capacity = (m->capacity == 0) ? 16 : 2 * m->capacity;
+  m->precolor = resize(m->precolor, m->capacity, sizeof(int));
+  m->colors = resize(m->colors, m->capacity, sizeof(int));
+}
+
+// [Auxiliary] Makes room for at least count more arcs in a map
+
+static void reserve_arcs(struct mapcol *m, int count) {
+  if (m->n_arcs + count <= m->arc_capacity) return;
+
+  while (m->arc_capacity < m->n_arcs + count)
+    m->arc_capacity = (m->arc_capacity == 0) ? 16 : 2 * m->arc_capacity;
+
+  m->from = resize(m->from, m->arc_capacity, sizeof(int));
+  m->to = resize(m->to, m->arc_capacity, sizeof(int));
+}
+
+// [Auxiliary] Adds an arc from a (valid) country of a map to another one
+
+static void add_arc(struct mapcol *m, int a, int b) {
+  reserve_arcs(m, 1);
+
+  m->from[m->n_arcs] = a;
+  m->to[m->n_arcs++] = b;
+}
+
+// [Auxiliary] Sets the error of a map and returns status
+
+static enum mapcol_status fail(struct mapcol *m, enum mapcol_status status,
+                               const char *error) {
+  m->error = error;
+  return status;
+}
+
+// [Auxiliary] Builds the integer form of a map (m->graph), in which
+// precolors beyond the first n_colors colors are taken as colors that no
+// other country has
+
+static struct graph * build(struct mapcol *m, int n_colors) {
+  struct graph *g = m->graph = graph_from_arcs(m->n_countries, m->n_arcs,
+                                               m->from, m->to);
+
+  for (int v = 0; v < m->n_countries; v++)
+    g->colors[v] = (m->precolor[v] < n_colors) ? m->precolor[v] : -2;
+
+  return g;
+}
+
+// [Auxiliary] Clears the report of a map (see mapcol_report)
+
+static void clear_report(struct mapcol *m) {
+  free(m->witness);
+  m->witness = NULL;
+
+  struct mapcol_report *r = &m->report;
+
+  r->planar = -1;
+  r->n_borders = r->n_faces = 0;
+  r->k5 = false;
+  r->witness = NULL;
+  r->n_witness = 0;
+  r->width = -1;
+  r->searched = false;
+  r->cut_short = false;
+  r->n_precolored = r->n_forced = r->n_searched = 0;
+  r->empty = -1;
+  r->bandwidth_before = r->bandwidth_after = -1;
+}
+
+// [Auxiliary] Fills in the report of a map with what a solve found out
+
+static void fill_report(struct mapcol *m, struct solve *sv) {
+  struct mapcol_report *r = &m->report;
+  struct planarity *p = sv->planarity;
+
+  if (p != NULL) {
+    r->planar = p->planar;
+    r->n_borders = p->n_edges;
+    r->n_faces = p->n_faces;
+  }
+
+  if (p != NULL && p->witness != NULL) {
+    m->witness = resize(NULL, 2 * p->n_witness, sizeof(int));
+    memcpy(m->witness, p->witness, sizeof(int) * 2 * p->n_witness);
+
+    r->k5 = p->k5;
+    r->witness = m->witness;
+    r->n_witness = p->n_witness;
+  }
+
+  r->width = sv->width;
+  r->searched = sv->searched;
+  r->n_precolored = sv->n_precolored;
+  r->n_forced = sv->n_forced;
+  r->n_searched = sv->n_searched;
+  r->empty = sv->empty;
+  r->bandwidth_before = sv->bandwidth_before;
+  r->bandwidth_after = sv->bandwidth_after;
+}
+
+// [Auxiliary] Copies the statistics of the search that's running on the
+// current thread to those of map m
+
+static void export_stats(struct mapcol *m) {
+  m->stats.elapsed = stats_now() - stats.start;
+  m->stats.nodes = stats.nodes;
+  m->stats.backtracks = stats.backtracks;
+  m->stats.restarts = stats.restarts;
+  m->stats.depth = stats.depth;
+  m->stats.max_depth = stats.max_depth;
+  m->stats.first_solution = stats.first_solution;
+  m->stats.backtracks_at = stats.backtracks_at;
+  m->stats.histogram_size = stats.histogram_size;
+}
+
+// [Auxiliary] Passes the statistics of the solve of a map (arg) to its
+// progress callback (see stats_start)
+
+static void report_progress(void *arg) {
+  struct mapcol *m = arg;
+
+  export_stats(m);
+  m->progress(&m->stats, m->progress_arg);
+}
+
+// Sets options to the defaults (4 colors, no timeout, seed 0, no renumbering)
+
+void mapcol_default_options(struct mapcol_options *o) {
+  o->n_colors = 4;
+  o->timeout = 0;
+  o->seed = 0;
+  o->renumber = false;
+  o->witness = false;
+  o->progress = NULL;
+  o->progress_arg = NULL;
+}
+
+// Creates an empty map (NULL if out of memory)
+
+struct mapcol * mapcol_create(void) {
+  struct mapcol *m = calloc(1, sizeof(*m));
+  if (m == NULL) return NULL;
+
+  solve_init(&m->solve, 0);
+  clear_report(m);
+
+  if ((m->names = names_create()) == NULL) {
+    free(m);
+    return NULL;
+  }
+
+  return m;
+}
+
+// Creates a map of n countries (0 ... n-1) in which country from[i] borders
+// country to[i], for 0 <= i < n_edges (NULL if out of memory, or if an
+// index is out of bounds or a country borders itself)
+
+struct mapcol * mapcol_from_edges(int n, int n_edges, const int *from,
+                                  const int *to) {
+  if (n < 0 || n_edges < 0) return NULL;
+
+  for (int i = 0; i < n_edges; i++)
+    if (from[i] < 0 || from[i] >= n || to[i] < 0 || to[i] >= n
+     || from[i] == to[i])
+      return NULL;
+
+  struct mapcol *m = calloc(1, sizeof(*m));
+  if (m == NULL) return NULL;
+
+  solve_init(&m->solve, 0);
+  clear_report(m);
+
+  ENTER(m, (mapcol_destroy(m), NULL));
+
+  m->capacity = n;
+  m->precolor = resize(NULL, n, sizeof(int));
+  m->colors = resize(NULL, n, sizeof(int));
+
+  for (m->n_countries = 0; m->n_countries < n; m->n_countries++) {
+    m->precolor[m->n_countries] = -1;
+    m->colors[m->n_countries] = -1;
+  }
+
+  // Each border becomes an arc each way
+
+  reserve_arcs(m, 2 * n_edges);
+
+  for (int i = 0; i < n_edges; i++) {
+    add_arc(m, from[i], to[i]);
+    add_arc(m, to[i], from[i]);
+  }
+
+  LEAVE();
+  return m;
+}
+
+// Returns the index of the country with the given name, which is added to
+// the map (without borders) if it isn't there yet. Returns -1 on error
+
+int mapcol_country(struct mapcol *m, const char *name) {
+  if (m->names == NULL || name == NULL) {
+    fail(m, MAPCOL_INVALID, "mapcol_country: the map has unnamed countries");
+    return -1;
+  }
+
+  int index = names_find(m->names, (char *) name);
+  if (index != -1) return index;
+
+  ENTER(m, -1);
+
+  grow_countries(m);
+
+  if (names_add(m->names, (char *) name) != m->n_countries)
+    terminate("libmapcol: out of memory");
+
+  m->precolor[m->n_countries] = -1;
+  m->colors[m->n_countries] = -1;
+
+  LEAVE();
+  return m->n_countries++;
+}
+
+// Adds a country and its neighbours by name, as a line of mapcol's input
+// does (the neighbours are added too, if they aren't there yet). A border
+// only needs to be listed by one of its countries, and the neighbours of a
+// country are kept in the order in which it lists them (the solver may
+// break ties by that order). Returns the index of the country, or -1 on
+// error
+
+int mapcol_add(struct mapcol *m, const char *name, const char **neighbours,
+               int n_neighbours) {
+  int country = mapcol_country(m, name);
+  if (country == -1) return -1;
+
+  // With room for all of the arcs, adding them can't fail
+
+  ENTER(m, -1);
+  reserve_arcs(m, n_neighbours);
+  LEAVE();
+
+  for (int i = 0; i < n_neighbours; i++) {
+    int neighbour = mapcol_country(m, neighbours[i]);
+    if (neighbour == -1) return -1;
+
+    if (neighbour == country) {
+      fail(m, MAPCOL_INVALID, "mapcol_add: a country borders itself");
+      return -1;
+    }
+
+    add_arc(m, country, neighbour);
+  }
+
+  return country;
+}
+
+// Adds a border between two countries (given by index)
+
+enum mapcol_status mapcol_border(struct mapcol *m, int a, int b) {
+  if (a < 0 || a >= m->n_countries || b < 0 || b >= m->n_countries || a == b)
+    return fail(m, MAPCOL_INVALID, "mapcol_border: invalid countries");
+
+  ENTER(m, MAPCOL_ERROR);
+  add_arc(m, a, b);
+  add_arc(m, b, a);
+  LEAVE();
+
+  return MAPCOL_OK;
+}
+
+// Precolors a country with a color index (-1 removes its precolor). A
+// precolor beyond the number of colors of a solve is taken as a color that
+// no other country can have, as mapcol does with colors outside its palette
+
+enum mapcol_status mapcol_precolor(struct mapcol *m, int country, int color) {
+  if (country < 0 || country >= m->n_countries || color < -1)
+    return fail(m, MAPCOL_INVALID, "mapcol_precolor: invalid argument");
+
+  m->precolor[country] = color;
+  return MAPCOL_OK;
+}
+
+// Returns the number of countries of a map
+
+int mapcol_size(struct mapcol *m) {
+  return m->n_countries;
+}
+
+// Returns the name of a country (NULL if it was added by index only)
+
+const char * mapcol_name(struct mapcol *m, int country) {
+  return (m->names != NULL) ? names_get(m->names, country) : NULL;
+}
+
+// Colors a map (options can be NULL, for the defaults). On success, the
+// colors can be read with mapcol_colors. On MAPCOL_TIMEOUT, they hold the
+// deepest partial coloring that the search reached instead
+
+enum mapcol_status mapcol_solve(struct mapcol *m,
+                                const struct mapcol_options *options) {
+  struct mapcol_options defaults;
+
+  if (options == NULL) {
+    mapcol_default_options(&defaults);
+    options = &defaults;
+  }
+
+  if (options->n_colors <= 0 || options->timeout < 0)
+    return fail(m, MAPCOL_INVALID, "mapcol_solve: invalid options");
+
+  ENTER(m, MAPCOL_ERROR);
+
+  clear_report(m);
+
+  struct graph *g = build(m, options->n_colors);
+  struct solve *sv = &m->solve;
+
+  solve_init(sv, options->n_colors);
+  sv->deadline = (options->timeout > 0) ? stats_now() + options->timeout : 0;
+  sv->seed = options->seed;
+  sv->renumber = options->renumber;
+  sv->witness = options->witness;
+
+  m->progress = options->progress;
+  m->progress_arg = options->progress_arg;
+
+  stats_start(m->n_countries, (m->progress != NULL) ? report_progress : NULL,
+              m);
+
+  bool colored = solve_graph(sv, g);
+
+  for (int v = 0; v < m->n_countries; v++)
+    if (m->precolor[v] != -1)
+      m->colors[v] = m->precolor[v];
+    else if (colored)
+      m->colors[v] = sv->color[v];
+    else
+      m->colors[v] = (sv->best != NULL) ? sv->best[v] : -1;
+
+  enum mapcol_status status = colored ? MAPCOL_OK
+                            : sv->expired ? MAPCOL_TIMEOUT : MAPCOL_UNCOLORABLE;
+
+  fill_report(m, sv);
+
+  // The map keeps the statistics (and their histogram) of its last solve
+
+  export_stats(m);
+
+  free(m->histogram);
+  m->histogram = stats.backtracks_at;
+  stats.backtracks_at = NULL;
+
+  release(m);
+  LEAVE();
+
+  m->error = NULL;
+  return status;
+}
+
+// Returns the color index of each country after the last solve: its
+// precolor if it has one, and -1 if it wasn't colored (or if the map has
+// been enumerated since). The array belongs to the map, and it's valid
+// until the map changes or is destroyed
+
+const int * mapcol_colors(struct mapcol *m) {
+  return m->colors;
+}
+
+// Counts the colorings of a map with n_colors colors that leave its
+// precolored countries as they are, and stores the count in *count, as a
+// decimal number. The string belongs to the map, and it's valid until the
+// next call on it. Maps that are too wide for dynamic programming are
+// counted by backtracking, which gives up after timeout seconds (0: never)
+// with MAPCOL_TIMEOUT (and *count set to NULL)
+
+enum mapcol_status mapcol_count(struct mapcol *m, int n_colors, double timeout,
+                                const char **count) {
+  if (n_colors <= 0 || timeout < 0)
+    return fail(m, MAPCOL_INVALID, "mapcol_count: invalid argument");
+
+  free(m->count);
+  m->count = NULL;
+
+  clear_report(m);
+
+  ENTER(m, MAPCOL_ERROR);
+
+  struct graph *g = build(m, n_colors);
+
+  double deadline = (timeout > 0) ? stats_now() + timeout : 0;
+
+  m->count = treedec_count(g, n_colors, &m->report.width, deadline);
+  m->report.searched = m->report.width > treedec_limit(n_colors);
+  m->report.cut_short = (m->count == NULL);
+
+  release(m);
+  LEAVE();
+
+  *count = m->count;
+
+  m->error = NULL;
+  return m->report.cut_short ? MAPCOL_TIMEOUT : MAPCOL_OK;
+}
+
+struct enumeration {
+  struct mapcol *m;
+  void (*found)(const int *colors, void *arg);
+  void *arg;
+};
+
+// [Auxiliary] Passes a coloring of the uncolored countries of a map to the
+// callback of mapcol_enumerate, along with the precolors
+
+static void pass_coloring(int *color, void *arg) {
+  struct enumeration *e = arg;
+  struct mapcol *m = e->m;
+
+  for (int v = 0; v < m->n_countries; v++)
+    m->colors[v] = (m->precolor[v] != -1) ? m->precolor[v] : color[v];
+
+  e->found(m->colors, e->arg);
+}
+
+// Calls found with each coloring of a map with n_colors colors that leaves
+// its precolored countries as they are (colors is in the format of
+// mapcol_colors, and it's only valid during the call), as soon as it's
+// found, until timeout seconds have passed (0: never, see cut_short in
+// mapcol_report). Returns the number of colorings found, or -1 on error
+
+long mapcol_enumerate(struct mapcol *m, int n_colors, double timeout,
+                      void (*found)(const int *colors, void *arg), void *arg) {
+  if (n_colors <= 0 || timeout < 0) {
+    fail(m, MAPCOL_INVALID, "mapcol_enumerate: invalid argument");
+    return -1;
+  }
+
+  clear_report(m);
+
+  ENTER(m, -1);
+
+  struct graph *g = build(m, n_colors);
+  struct enumeration e = {m, found, arg};
+
+  double deadline = (timeout > 0) ? stats_now() + timeout : 0;
+
+  long n_found = treedec_enumerate(g, n_colors, pass_coloring, &e,
+                                   &m->report.width, deadline,
+                                   &m->report.cut_short);
+  m->report.searched = m->report.width > treedec_limit(n_colors);
+
+  // The colors were overwritten by the colorings (see mapcol_colors)
+
+  for (int v = 0; v < m->n_countries; v++)
+    m->colors[v] = -1;
+
+  release(m);
+  LEAVE();
+
+  m->error = NULL;
+  return n_found;
+}
+
+// Returns the statistics of the search of the last solve of a map (they
+// belong to the map, and they're valid until the next solve)
+
+const struct mapcol_stats * mapcol_stats(struct mapcol *m) {
+  return &m->stats;
+}
+
+// Returns what the last solve, count or enumeration of a map found out on
+// the way (it belongs to the map, and it's valid until the next one)
+
+const struct mapcol_report * mapcol_report(struct mapcol *m) {
+  return &m->report;
+}
+
+// Returns a description of the last error of a map (NULL if there's none)
+
+const char * mapcol_error(struct mapcol *m) {
+  return m->error;
+}
+
+// Destroys a map (memory deallocation)
+
+void mapcol_destroy(struct mapcol *m) {
+  if (m == NULL) return;
+
+  if (m->names != NULL) names_destroy(m->names);
+
+  release(m);
+
+  free(m->precolor);
+  free(m->colors);
+  free(m->from);
+  free(m->to);
+  free(m->count);
+  free(m->histogram);
+  free(m->witness);
+  free(m);
+}
@@ -2,59 +2,242 @@
 #include <stdio.h>
 
 #include "utilities.h"
+#include "constants.h"
 #include "ADT_List.h"
 #include "color.h"
 #include "parse.h"
+#include "progress.h"
+#include "phase.h"
+#include "batch.h"
+#include "serve.h"
+#include "palette.h"
+#include "cache.h"
 
-struct options options; // See utilities.h for the "struct options" definition
+_Thread_local struct options options; // See utilities.h for the "struct options" definition
 
 int main(int argc, char **argv) {
-  char *colors[] = {"red", "green", "blue", "yellow", "orange",
-                    "violet", "cyan", "pink", "brown", "grey"};
-
-  int max_colors = sizeof(colors) / sizeof(colors[0]);
+  bool timed_out = false; // True if the --timeout deadline has passed
+  List *non_sorted_map = NULL;
+  struct canon *key = NULL;
 
+  set_fatal_handler(exit_on_fatal);
   process_CLA(argc, argv);
 
   int n_colors = options.n_colors;
-  if (n_colors <= 0 || n_colors > max_colors)
+  if (n_colors <= 0)
     terminate("Invalid number of colors");
 
+  // The palette has at least n_colors colors (the default ones, or the
+  // ones given with -p, followed by generated ones if they're not enough)
+
+  FILE *palette_file = NULL;
+
+  if (options.palette_path != NULL
+   && (palette_file = fopen(options.palette_path, "r")) == NULL)
+    terminate("Cannot open palette file");
+
+  int max_colors;
+  char **colors = palette_create(n_colors, palette_file, &max_colors);
+
+  if (palette_file != NULL) fclose(palette_file);
+  if (colors == NULL) terminate("Invalid palette");
+
+  if (options.batch) {
+    int status = run_batch(options.files, options.n_files, colors, max_colors);
+
+    if (options.input_file != stdin) fclose(options.input_file);
+    palette_destroy(colors, max_colors);
+
+    return status;
+  }
+
+  if (options.serve) {
+    List *map;
+
+    // If the commands are read from stdin, the initial map can only come
+    // from a file (-i). Otherwise, the service starts with an empty map
+
+    if (options.input_file != stdin || options.socket_path != NULL)
+      map = read_map(options.input_file);
+    else
+      map = map_create();
+
+    if (!is_map_valid(map)) {
+      cleanup(map);
+      terminate("Map is invalid (format rules weren't met)");
+    }
+
+    int status = serve(map, colors, max_colors);
+
+    cleanup(map);
+    if (options.input_file != stdin) fclose(options.input_file);
+    palette_destroy(colors, max_colors);
+
+    return status;
+  }
+
+  if (options.phases) phase_init(options.perf);
+
+  // The deadline covers the whole run, not just the search
+  set_deadline(options.timeout);
+
+  phase_begin("read_map");
   List *map = read_map(options.input_file);
+  phase_end();
 
-  if (!is_map_valid(map)) {
+  phase_begin("is_map_valid");
+  bool valid = is_map_valid(map);
+  phase_end();
+
+  if (!valid) {
     cleanup(map);
     terminate("Map is invalid (format rules weren't met)");
   }
 
   if (options.c_activated) {
-    printf("Map is %scolored correctly\n",
-          is_valid_coloring(map, colors, max_colors, n_colors) ? "" : "not ");
+    phase_begin("is_valid_coloring");
+    bool valid_coloring = is_valid_coloring(map, colors, max_colors, n_colors);
+    phase_end();
+
+    printf("Map is %scolored correctly\n", valid_coloring ? "" : "not ");
     goto exit_prog; // Go directly to memory clean up & file closing
   }
 
+  // Counting and enumerating the colorings leave the map as it is, so
+  // there's nothing to cache or to print afterwards
+
+  if (options.count) {
+    phase_begin("count_colorings");
+    char *count = count_colorings(map, colors, n_colors);
+    phase_end();
+
+    // A count that the deadline cut short isn't printed at all (it would
+    // be a meaningless lower bound)
+
+    if (count != NULL)
+      printf("The map has %s colorings with %d colors\n", count, n_colors);
+    else
+      timed_out = true;
+
+    free(count);
+    goto exit_prog;
+  }
+
+  if (options.enumerate) {
+    phase_begin("enumerate_colorings");
+    long found = enumerate_colorings(map, colors, n_colors);
+    fflush(stdout);
+    phase_end();
+
+    if (found == 0)
+      printf("The map cannot be colored with %d colors\n", n_colors);
+    else if (found == -1)
+      timed_out = true;
+
+    goto exit_prog;
+  }
+
+  // If the map (or a relabeling of it) has been colored before, the
+  // cached coloring is printed instead of running the search
+
+  if (options.cache_dir != NULL) {
+    phase_begin("cache_lookup");
+    key = cache_key(map, colors, n_colors);
+    bool cached = key != NULL
+               && cache_lookup(key, map, colors, max_colors, n_colors);
+    phase_end();
+
+    if (cached) {
+      if (options.stats) fprintf(stderr, "[stats] cache hit\n");
+
+      phase_begin("map_print");
+      map_print(map);
+      fflush(stdout);
+      phase_end();
+
+      goto exit_prog;
+    }
+  }
+
   // Keep a non-sorted version of the input map, so that we can
   // print the countries in the same order as they were entered
 
-  List *non_sorted_map = map_copy(map);
+  phase_begin("map_copy");
+  non_sorted_map = map_copy(map);
+  phase_end();
 
   // Heuristic: high degree countries (vertices) will be colored first
+  phase_begin("sort_map");
   sort_map(map);
+  phase_end();
 
   // If map can be colored, print the result. Otherwise, notify
   // the user that the map couldn't be colored
 
-  if (color_map(map, colors, n_colors) == true)
+  phase_begin("color_map");
+  if (options.stats) progress_start();
+  bool colored = color_map(map, colors, n_colors);
+  if (options.stats) progress_stop();
+  phase_end();
+
+  if (options.stats) progress_print("stats", color_map_stats());
+
+  int before, after;
+
+  if (renumber_bandwidth(&before, &after))
+    fprintf(stderr, "Bandwidth: %d before renumbering, %d after\n",
+            before, after);
+  else if (options.renumber)
+    fprintf(stderr, "Bandwidth: not renumbered (the map wasn't searched)\n");
+
+  // If the deadline has passed, the deepest partial coloring that was
+  // found is printed (the rest of the countries remain uncolored)
+
+  timed_out = deadline_expired();
+  if (timed_out) restore_best_coloring(map);
+
+  color_map_free();
+
+  phase_begin("map_print");
+
+  if (colored == true || timed_out)
     map_print(non_sorted_map);
   else
     printf("The map cannot be colored with %d colors\n", n_colors);
 
+  fflush(stdout); // Make sure that printing is attributed to this phase
+  phase_end();
+
+  // The cache is keyed on the input order of the map (see cache.h)
+
+  if (colored && key != NULL) {
+    phase_begin("cache_store");
+    cache_store(key, non_sorted_map, colors, n_colors);
+    phase_end();
+  }
+
 exit_prog:
 
+  phase_begin("cleanup");
   cleanup(map);
+  phase_end();
 
-  if (!options.c_activated)        free(non_sorted_map);
+  free(non_sorted_map);
+  if (key != NULL) canon_destroy(key);
   if (options.input_file != stdin) fclose(options.input_file);
 
+  phase_report();
+  phase_cleanup();
+
+  palette_destroy(colors, max_colors);
+
+  if (timed_out) {
+    fprintf(stderr, "Deadline expired, %s\n",
+            options.count ? "the count was cut short"
+          : options.enumerate ? "the enumeration was cut short"
+          : "the map was only partially colored");
+    return EXIT_TIMEOUT;
+  }
+
   return 0;
 }
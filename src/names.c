@@ -0,0 +1,152 @@
+// In this implementation, the table uses open addressing with linear
+// probing. The slots store indices into an array of names, which grows
+// as names are added (so that names_get is a simple array access). The
+// number of slots is always a power of two, and it's doubled whenever
+// the table becomes half full.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "names.h"
+
+struct names {
+  char **names;  // names[i] is the name with index i
+  int count;     // Number of names in the table
+  int capacity;  // Size of the names array
+  int *slots;    // Hash slots (-1 for empty slots, index of a name otherwise)
+  int n_slots;   // Number of slots (power of two)
+};
+
+// [Auxiliary] FNV-1a hash of a string
+
+static unsigned hash(char *str) {
+  unsigned h = 2166136261u;
+
+  for ( ; *str != '\0'; str++)
+    h = (h ^ (unsigned char) *str) * 16777619u;
+
+  return h;
+}
+
+// [Auxiliary] Returns the slot in which a name is (or should be) stored
+
+static int find_slot(struct names *table, char *name) {
+  int mask = table->n_slots - 1;
+  int slot = hash(name) & mask;
+
+  while (table->slots[slot] != -1
+      && strcmp(table->names[table->slots[slot]], name))
+    slot = (slot + 1) & mask;
+
+  return slot;
+}
+
+// [Auxiliary] Doubles the number of slots and rehashes the names.
+// Returns false if the memory cannot be allocated
+
+static bool grow_slots(struct names *table) {
+  int *old_slots = table->slots;
+  int old_n_slots = table->n_slots;
+
+  table->n_slots *= 2;
+  table->slots = malloc(sizeof(int) * table->n_slots);
+
+  if (table->slots == NULL) {
+    table->slots = old_slots;
+    table->n_slots = old_n_slots;
+    return false;
+  }
+
+  memset(table->slots, -1, sizeof(int) * table->n_slots);
+
+  for (int i = 0; i < old_n_slots; i++)
+    if (old_slots[i] != -1)
+      table->slots[find_slot(table, table->names[old_slots[i]])] = old_slots[i];
+
+  free(old_slots);
+  return true;
+}
+
+// Creates and returns an empty table (or NULL in case of error)
+
+struct names * names_create(void) {
+  struct names *table = malloc(sizeof(*table));
+  if (table == NULL) return NULL;
+
+  table->count = 0;
+  table->capacity = 64;
+  table->n_slots = 128;
+
+  table->names = malloc(sizeof(char *) * table->capacity);
+  table->slots = malloc(sizeof(int) * table->n_slots);
+
+  if (table->names == NULL || table->slots == NULL) {
+    names_destroy(table);
+    return NULL;
+  }
+
+  memset(table->slots, -1, sizeof(int) * table->n_slots);
+
+  return table;
+}
+
+// Returns the index of a name in the table (-1 if it's not there)
+
+int names_find(struct names *table, char *name) {
+  return table->slots[find_slot(table, name)];
+}
+
+// Adds a name to the table (a copy of it is kept) and returns its index,
+// which is the number of names added before it. If the name is already
+// in the table, its existing index is returned (-1 in case of error)
+
+int names_add(struct names *table, char *name) {
+  int slot = find_slot(table, name);
+  if (table->slots[slot] != -1) return table->slots[slot];
+
+  if (table->count == table->capacity) {
+    char **names = realloc(table->names, sizeof(char *) * 2 * table->capacity);
+    if (names == NULL) return -1;
+
+    table->names = names;
+    table->capacity *= 2;
+  }
+
+  char *copy = malloc(strlen(name) + 1);
+  if (copy == NULL) return -1;
+
+  strcpy(copy, name);
+  table->names[table->count] = copy;
+  table->slots[slot] = table->count;
+
+  // Keep the load factor below 1/2, so that probe sequences stay short
+  if (2 * ++table->count > table->n_slots && !grow_slots(table))
+    return -1;
+
+  return table->count - 1;
+}
+
+// Returns the name that has the given index (NULL if out of bounds)
+
+char * names_get(struct names *table, int index) {
+  return (index < 0 || index >= table->count) ? NULL : table->names[index];
+}
+
+// Returns the number of names in the table
+
+int names_count(struct names *table) {
+  return table->count;
+}
+
+// Destroys a table (memory deallocation)
+
+void names_destroy(struct names *table) {
+  if (table->names != NULL)
+    for (int i = 0; i < table->count; i++)
+      free(table->names[i]);
+
+  free(table->names);
+  free(table->slots);
+  free(table);
+}
@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+#include "constants.h"
+#include "palette.h"
+
+static char *default_colors[DEFAULT_COLORS] = {
+  "red", "green", "blue", "yellow", "orange",
+  "violet", "cyan", "pink", "brown", "grey"
+};
+
+// [Auxiliary] Returns true if a color name is a valid word (see parse.c)
+// and isn't the special "nocolor" word
+
+static bool valid_name(char *name) {
+  if (name[0] == '\0' || strlen(name) > MAX_WORD) return false;
+
+  for (int i = 0; name[i] != '\0'; i++)
+    if (!isalnum(name[i]) && name[i] != '_')
+      return false;
+
+  return strcmp(name, "nocolor") != 0;
+}
+
+// [Auxiliary] Appends a copy of a color name to the palette, growing it
+// if needed. Returns false if the name is invalid, a duplicate, or if the
+// memory cannot be allocated
+
+static bool append(char ***palette, int *size, int *capacity, char *name) {
+  if (!valid_name(name) || palette_find(*palette, *size, name) != -1)
+    return false;
+
+  if (*size == *capacity) {
+    *capacity = 2 * *capacity;
+
+    char **grown = realloc(*palette, sizeof(char *) * *capacity);
+    if (grown == NULL) return false;
+
+    *palette = grown;
+  }
+
+  if (((*palette)[*size] = malloc(strlen(name) + 1)) == NULL) return false;
+
+  strcpy((*palette)[(*size)++], name);
+  return true;
+}
+
+// Returns a palette with at least n_colors colors. If fp isn't NULL, the
+// first colors are read from it (words separated by whitespace), instead
+// of being the default ones. The number of colors in the palette is stored
+// in *size. Returns NULL if a color name is invalid or appears twice, or
+// if the memory cannot be allocated
+
+char ** palette_create(int n_colors, FILE *fp, int *size) {
+  int capacity = (n_colors > DEFAULT_COLORS) ? n_colors : DEFAULT_COLORS;
+
+  char **palette = malloc(sizeof(char *) * capacity);
+  if (palette == NULL) return NULL;
+
+  *size = 0;
+
+  if (fp == NULL) {
+    for (int i = 0; i < DEFAULT_COLORS; i++)
+      if (!append(&palette, size, &capacity, default_colors[i]))
+        goto error;
+  } else {
+    char word[MAX_WORD + 2]; // Longer words are caught by valid_name
+
+    while (fscanf(fp, "%33s", word) == 1)
+      if (!append(&palette, size, &capacity, word))
+        goto error;
+  }
+
+  // Generated names are numbered by their (1-based) position
+  for (char name[MAX_WORD + 1]; *size < n_colors; ) {
+    sprintf(name, "color%d", *size + 1);
+
+    if (!append(&palette, size, &capacity, name))
+      goto error;
+  }
+
+  return palette;
+
+error:
+
+  palette_destroy(palette, *size);
+  return NULL;
+}
+
+// Returns the index of a color in the palette (-1 if it isn't there)
+
+int palette_find(char **palette, int size, char *color) {
+  for (int i = 0; i < size; i++)
+    if (!strcmp(palette[i], color))
+      return i;
+
+  return -1;
+}
+
+// Destroys a palette (memory deallocation)
+
+void palette_destroy(char **palette, int size) {
+  for (int i = 0; i < size; i++)
+    free(palette[i]);
+
+  free(palette);
+}
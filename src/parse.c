@@ -18,6 +18,7 @@
 //     country must have its own line (colour/neighbour info)
 // (B) If K is neighbour of L, then L must be neighbour of K
 // (C) Each line must end with a newline ('\n')
+// (D) Each country must have a single line
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -39,38 +40,37 @@ bool is_whitespace(int ch) {
   return (ch == ' ' || ch == '\t');
 }
 
-// Returns the map description represented as an adjacency list
-
-List * read_map(FILE *fp) {
-  List *map = malloc(sizeof(List) * MAX_COUNTRIES);
-  if (map == NULL) terminate("read_map: out of memory");
-
-  for (int i = 0; i < MAX_COUNTRIES; i++)
-    if ((map[i] = list_create()) == NIL_LIST)
-      terminate("read_map: out of memory");
+// Reads a map description from fp into map, an array of MAX_COUNTRIES
+// empty lists (see map_create). Returns NULL on success, or a message
+// describing the error otherwise (the words read up to that point are
+// kept in map, so that they can be deallocated with map_reset/cleanup)
 
+char * read_map_into(FILE *fp, List *map) {
   char buf[4096]; // Line buffer
-  char *word;
+  char word[MAX_WORD+1]; // +1 for '\0' (the lists keep copies of the words)
 
   int n_countries = 0;
+  options.n_countries = 0;
 
   // Read from input stream until there are no more lines
   for ( ; fgets(buf, sizeof(buf), fp); n_countries++) {
     if (n_countries >= MAX_COUNTRIES)
-      terminate("read_map: too many lines");
+      return "read_map: too many lines";
+
+    // Lists up to (and including) the current one have to be deallocated
+    options.n_countries = n_countries + 1;
 
     // Split each line into words and save them in the corresponding list
     for (int i = 0; buf[i] != '\0'; i++) {
       for ( ; is_whitespace(buf[i]); i++); // Skip whitespace
 
       if (!is_valid(buf[i]))
-        terminate("read_map: invalid input"); // Unknown token found
-
-      word = malloc(sizeof(char) * (MAX_WORD+1)); // +1 for '\0'
-      if (word == NULL) terminate("read_map: out of memory");
+        return "read_map: invalid input"; // Unknown token found
 
       for (int j = 0; is_valid(buf[i]); i++, j++) {
-        if (j >= MAX_WORD) terminate("read_map: word too big");
+        if (j >= MAX_WORD)
+          return "read_map: word too big";
+
         word[j] = buf[i];
 
         if (!is_valid(buf[i+1])) word[++j] = '\0';
@@ -81,5 +81,16 @@ List * read_map(FILE *fp) {
   }
 
   options.n_countries = n_countries;
+  return NULL;
+}
+
+// Returns the map description represented as an adjacency list
+
+List * read_map(FILE *fp) {
+  List *map = map_create();
+
+  char *error = read_map_into(fp, map);
+  if (error != NULL) terminate(error);
+
   return map;
 }
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "phase.h"
+
+#define MAX_PHASES 16
+#define N_COUNTERS 4
+
+// Names of the hardware counters (in the order they're read from the group)
+
+static char *counter_names[N_COUNTERS] = {
+  "cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+struct phase {
+  char *name;
+  long long wall_ns;
+  long long cpu_ns;
+  long long counters[N_COUNTERS];
+};
+
+static struct phase phases[MAX_PHASES];
+static int n_phases = 0;
+
+static bool enabled = false;
+static bool requested = false; // True if the hardware counters were asked for
+static bool counting = false;  // True if the hardware counters are available
+
+static long long wall_start, cpu_start; // Start times of the current phase
+
+#ifdef __linux__
+static int counter_fds[N_COUNTERS] = {-1, -1, -1, -1};
+#endif
+
+// [Auxiliary] Returns the current time of the given clock in nanoseconds
+
+static long long now_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#ifdef __linux__
+
+// [Auxiliary] Opens the hardware counters as a single group (the first
+// counter is the group leader), so that they are enabled, disabled and
+// read together. Returns false if the counters are unavailable
+
+static bool open_counters(void) {
+  unsigned long long configs[N_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+  };
+
+  for (int i = 0; i < N_COUNTERS; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = configs[i];
+    attr.disabled = (i == 0); // Only the leader starts out disabled
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    int leader = (i == 0) ? -1 : counter_fds[0];
+
+    counter_fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+
+    if (counter_fds[i] == -1) {
+      phase_cleanup();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#endif
+
+// Enables the instrumentation (it's disabled by default, in which case the
+// rest of the methods do nothing). If hw_counters is true, the hardware
+// performance counters are recorded too (when the platform allows it)
+
+void phase_init(bool hw_counters) {
+  enabled = true;
+  requested = hw_counters;
+
+#ifdef __linux__
+  if (hw_counters) counting = open_counters();
+#endif
+}
+
+// Starts timing a new phase (phases can't be nested)
+
+void phase_begin(char *name) {
+  if (!enabled || n_phases >= MAX_PHASES) return;
+
+  phases[n_phases].name = name;
+
+#ifdef __linux__
+  if (counting) {
+    ioctl(counter_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counter_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+
+  cpu_start = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+  wall_start = now_ns(CLOCK_MONOTONIC);
+}
+
+// Stops timing the current phase
+
+void phase_end(void) {
+  if (!enabled || n_phases >= MAX_PHASES) return;
+
+  struct phase *p = &phases[n_phases++];
+
+  p->wall_ns = now_ns(CLOCK_MONOTONIC) - wall_start;
+  p->cpu_ns = now_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+
+#ifdef __linux__
+  if (counting) {
+    ioctl(counter_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // With PERF_FORMAT_GROUP, the number of counters precedes their values
+    unsigned long long values[1 + N_COUNTERS];
+
+    if (read(counter_fds[0], values, sizeof(values)) != sizeof(values))
+      memset(values, 0, sizeof(values));
+
+    for (int i = 0; i < N_COUNTERS; i++)
+      p->counters[i] = values[1 + i];
+  }
+#endif
+}
+
+// Prints the recorded phases to stderr, as a single JSON line
+
+void phase_report(void) {
+  if (!enabled) return;
+
+  fprintf(stderr, "{\"phases\":[");
+
+  for (int i = 0; i < n_phases; i++) {
+    fprintf(stderr, "%s{\"name\":\"%s\",\"wall_ns\":%lld,\"cpu_ns\":%lld",
+            (i == 0) ? "" : ",", phases[i].name, phases[i].wall_ns,
+            phases[i].cpu_ns);
+
+    // Unavailable counters are reported as null, so that the format of
+    // the output doesn't depend on the platform
+
+    for (int j = 0; requested && j < N_COUNTERS; j++) {
+      if (counting)
+        fprintf(stderr, ",\"%s\":%lld", counter_names[j],
+                phases[i].counters[j]);
+      else
+        fprintf(stderr, ",\"%s\":null", counter_names[j]);
+    }
+
+    fprintf(stderr, "}");
+  }
+
+  fprintf(stderr, "]}\n");
+}
+
+// Releases the resources used by the instrumentation
+
+void phase_cleanup(void) {
+#ifdef __linux__
+  for (int i = N_COUNTERS - 1; i >= 0; i--) {
+    if (counter_fds[i] != -1) close(counter_fds[i]);
+    counter_fds[i] = -1;
+  }
+#endif
+
+  counting = false;
+}
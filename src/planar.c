@@ -0,0 +1,1014 @@
+// This file contains the planarity test and the 5-coloring of planar
+// graphs, as described in planar.h. The test is a translation of the
+// left-right algorithm, as presented in U. Brandes, "The Left-Right
+// Planarity Test" (2009), in three depth-first searches:
+//
+// 1. Orientation: each edge is oriented along a DFS, and gets its lowpoints
+//    (the heights of the lowest and second lowest vertices its subtree
+//    returns to) and its nesting depth, from which the order in which the
+//    edges of each vertex are visited next is derived.
+//
+// 2. Testing: the return edges of the subtrees are kept in a stack of
+//    conflict pairs (two intervals of edges that have to be on different
+//    sides). The graph is planar if and only if no conflict pair ever has
+//    to hold conflicting edges on both sides.
+//
+// 3. Embedding: the sides of the edges are resolved through their chains
+//    of references, and the neighbours of each vertex are arranged around
+//    it accordingly.
+//
+// The searches are iterative (the stack of a vertex is revisited after
+// each of its tree edges), so that deep DFS trees don't overflow the call
+// stack. Edges are represented by half-edges: edge i of the input becomes
+// half-edges (from[i] -> to[i]) and (to[i] -> from[i]), and the orientation
+// picks one of the two.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fatal.h"
+#include "planar.h"
+
+struct interval {
+  int low, high; // Half-edges (-1: none)
+};
+
+struct conflict_pair {
+  struct interval left, right;
+};
+
+struct lr {
+  int n, m;                 // Number of vertices and edges (2m half-edges)
+  int *offsets;             // Half-edges out of v: offsets[v] ... offsets[v+1]-1
+  int *head, *tail, *twin;  // Endpoints of a half-edge, and its reverse
+
+  int *height;              // DFS height of each vertex (-1: not visited)
+  int *parent_edge;         // Tree half-edge into each vertex (-1: root)
+  int *ind;                 // Next half-edge to visit, per vertex
+  int *stack;               // DFS stack (2n vertices)
+  int *n_out;               // Number of oriented half-edges out of v, which
+  int *ordered;             // are ordered[offsets[v]] ... (by nesting depth)
+
+  bool *oriented;           // True for the half-edges picked by orientation
+  bool *skip;               // True for the tree edges that were descended
+  int *lowpt, *lowpt2, *nesting_depth;
+  int *ref, *side, *lowpt_edge, *stack_bottom;
+
+  struct conflict_pair *S;  // Stack of conflict pairs
+  int top;                  // Number of pairs in S
+
+  int *roots;               // Roots of the DFS trees (one per component)
+  int n_roots;
+
+  // Embedding: the half-edges out of each vertex form a circular list, in
+  // clockwise order (first[v] is where it starts)
+
+  int *cw, *ccw, *first;
+  int *left_ref, *right_ref;
+  int *chain;               // Scratch space for sign
+  long long *keys;          // Scratch space for sorting
+};
+
+// [Auxiliary] Allocates an array of count elements of the given size (or
+// terminates the program if the memory cannot be allocated)
+
+static void * alloc(size_t count, size_t size) {
+  void *p = calloc(count + 1, size);
+  if (p == NULL) terminate("planar: out of memory");
+
+  return p;
+}
+
+// [Auxiliary] Creates the state of a test over the graph with n vertices
+// and the m edges (from[i], to[i])
+
+static struct lr * lr_create(int n, int m, int *from, int *to) {
+  struct lr *t = alloc(1, sizeof(struct lr));
+
+  t->n = n;
+  t->m = m;
+
+  t->offsets = alloc(n + 1, sizeof(int));
+  t->head = alloc(2 * m, sizeof(int));
+  t->tail = alloc(2 * m, sizeof(int));
+  t->twin = alloc(2 * m, sizeof(int));
+
+  for (int i = 0; i < m; i++) {
+    t->offsets[from[i] + 1]++;
+    t->offsets[to[i] + 1]++;
+  }
+
+  for (int v = 0; v < n; v++)
+    t->offsets[v+1] += t->offsets[v];
+
+  int *fill = alloc(n, sizeof(int));
+  memcpy(fill, t->offsets, sizeof(int) * n);
+
+  for (int i = 0; i < m; i++) {
+    int h = fill[from[i]]++, r = fill[to[i]]++;
+
+    t->tail[h] = t->head[r] = from[i];
+    t->head[h] = t->tail[r] = to[i];
+    t->twin[h] = r;
+    t->twin[r] = h;
+  }
+
+  free(fill);
+
+  t->height = alloc(n, sizeof(int));
+  t->parent_edge = alloc(n, sizeof(int));
+  t->ind = alloc(n, sizeof(int));
+  t->stack = alloc(2 * n, sizeof(int));
+  t->n_out = alloc(n, sizeof(int));
+  t->ordered = alloc(2 * m, sizeof(int));
+
+  t->oriented = alloc(2 * m, sizeof(bool));
+  t->skip = alloc(2 * m, sizeof(bool));
+  t->lowpt = alloc(2 * m, sizeof(int));
+  t->lowpt2 = alloc(2 * m, sizeof(int));
+  t->nesting_depth = alloc(2 * m, sizeof(int));
+  t->ref = alloc(2 * m, sizeof(int));
+  t->side = alloc(2 * m, sizeof(int));
+  t->lowpt_edge = alloc(2 * m, sizeof(int));
+  t->stack_bottom = alloc(2 * m, sizeof(int));
+
+  t->S = alloc(2 * m, sizeof(struct conflict_pair));
+  t->roots = alloc(n, sizeof(int));
+
+  for (int v = 0; v < n; v++)
+    t->height[v] = t->parent_edge[v] = -1;
+
+  for (int h = 0; h < 2 * m; h++) {
+    t->ref[h] = -1;
+    t->side[h] = 1;
+  }
+
+  t->cw = alloc(2 * m, sizeof(int));
+  t->ccw = alloc(2 * m, sizeof(int));
+  t->first = alloc(n, sizeof(int));
+  t->left_ref = alloc(n, sizeof(int));
+  t->right_ref = alloc(n, sizeof(int));
+  t->chain = alloc(2 * m, sizeof(int));
+  t->keys = alloc(2 * m, sizeof(long long));
+
+  return t;
+}
+
+// [Auxiliary] Destroys the state of a test (memory deallocation)
+
+static void lr_destroy(struct lr *t) {
+  free(t->offsets); free(t->head); free(t->tail); free(t->twin);
+  free(t->height); free(t->parent_edge); free(t->ind); free(t->stack);
+  free(t->n_out); free(t->ordered);
+  free(t->oriented); free(t->skip);
+  free(t->lowpt); free(t->lowpt2); free(t->nesting_depth);
+  free(t->ref); free(t->side); free(t->lowpt_edge); free(t->stack_bottom);
+  free(t->S); free(t->roots);
+  free(t->cw); free(t->ccw); free(t->first);
+  free(t->left_ref); free(t->right_ref);
+  free(t->chain); free(t->keys);
+  free(t);
+}
+
+// [Auxiliary] Function that compares two long integers (needed for qsort)
+
+static int compare_keys(const void *p, const void *q) {
+  long long l = * (const long long *) p;
+  long long r = * (const long long *) q;
+
+  return (l > r) - (l < r);
+}
+
+// [Auxiliary] Sorts the oriented half-edges out of each vertex by their
+// nesting depth (ties are broken by half-edge number)
+
+static void order_by_nesting_depth(struct lr *t) {
+  long long base = 2LL * t->m + 1;
+  long long shift = 2LL * t->n + 2; // Nesting depths may be negative
+
+  for (int v = 0; v < t->n; v++) {
+    int *out = &t->ordered[t->offsets[v]];
+    int count = t->n_out[v];
+
+    for (int i = 0; i < count; i++)
+      t->keys[i] = (t->nesting_depth[out[i]] + shift) * base + out[i];
+
+    qsort(t->keys, count, sizeof(long long), compare_keys);
+
+    for (int i = 0; i < count; i++)
+      out[i] = t->keys[i] % base;
+  }
+}
+
+// [Auxiliary] Phase 1: orients the edges of the DFS tree rooted at root,
+// and computes their lowpoints and nesting depths
+
+static void orient(struct lr *t, int root) {
+  int sp = 0;
+
+  t->height[root] = 0;
+  t->stack[sp++] = root;
+
+  while (sp > 0) {
+    int v = t->stack[--sp];
+    int e = t->parent_edge[v];
+
+    for ( ; t->ind[v] < t->offsets[v+1]; t->ind[v]++) {
+      int vw = t->ind[v], w = t->head[vw];
+
+      if (!t->skip[vw]) {
+        if (t->oriented[vw] || t->oriented[t->twin[vw]])
+          continue; // Already oriented the other way
+
+        t->oriented[vw] = true;
+        t->ordered[t->offsets[v] + t->n_out[v]++] = vw;
+
+        t->lowpt[vw] = t->lowpt2[vw] = t->height[v];
+
+        if (t->height[w] == -1) { // Tree edge: descend to w, revisit v later
+          t->parent_edge[w] = vw;
+          t->height[w] = t->height[v] + 1;
+
+          t->skip[vw] = true;
+          t->stack[sp++] = v;
+          t->stack[sp++] = w;
+          break;
+        }
+
+        t->lowpt[vw] = t->height[w]; // Back edge
+      }
+
+      // Nesting depth: chordal edges (whose subtree returns to two distinct
+      // vertices below v) are nested inside the others
+
+      t->nesting_depth[vw] = 2 * t->lowpt[vw];
+      if (t->lowpt2[vw] < t->height[v]) t->nesting_depth[vw]++;
+
+      // Update the lowpoints of the parent edge
+
+      if (e != -1) {
+        if (t->lowpt[vw] < t->lowpt[e]) {
+          t->lowpt2[e] = (t->lowpt[e] < t->lowpt2[vw]) ? t->lowpt[e] : t->lowpt2[vw];
+          t->lowpt[e] = t->lowpt[vw];
+        } else if (t->lowpt[vw] > t->lowpt[e]) {
+          if (t->lowpt[vw] < t->lowpt2[e]) t->lowpt2[e] = t->lowpt[vw];
+        } else {
+          if (t->lowpt2[vw] < t->lowpt2[e]) t->lowpt2[e] = t->lowpt2[vw];
+        }
+      }
+    }
+  }
+}
+
+// [Auxiliary] Returns true if an interval isn't empty
+
+static inline bool interval_empty(struct interval *i) {
+  return i->low == -1 && i->high == -1;
+}
+
+// [Auxiliary] Returns true if an interval conflicts with half-edge b (its
+// highest return edge returns above the lowpoint of b)
+
+static inline bool conflicting(struct lr *t, struct interval *i, int b) {
+  return !interval_empty(i) && t->lowpt[i->high] > t->lowpt[b];
+}
+
+// [Auxiliary] Returns the lowest lowpoint of a conflict pair
+
+static int lowest(struct lr *t, struct conflict_pair *p) {
+  if (interval_empty(&p->left)) return t->lowpt[p->right.low];
+  if (interval_empty(&p->right)) return t->lowpt[p->left.low];
+
+  int l = t->lowpt[p->left.low], r = t->lowpt[p->right.low];
+  return (l < r) ? l : r;
+}
+
+// [Auxiliary] Swaps the two intervals of a conflict pair
+
+static inline void swap_sides(struct conflict_pair *p) {
+  struct interval temp = p->left;
+
+  p->left = p->right;
+  p->right = temp;
+}
+
+// [Auxiliary] Sets ref[e] (if e isn't -1)
+
+static inline void set_ref(struct lr *t, int e, int value) {
+  if (e != -1) t->ref[e] = value;
+}
+
+// [Auxiliary] Merges the return edges of ei (a half-edge out of the head of
+// e) with those of its preceding siblings. Returns false if that's
+// impossible (the graph isn't planar)
+
+static bool add_constraints(struct lr *t, int ei, int e) {
+  struct conflict_pair p = {{-1, -1}, {-1, -1}};
+
+  // Merge the return edges of ei into p.right
+
+  do {
+    struct conflict_pair q = t->S[--t->top];
+
+    if (!interval_empty(&q.left)) swap_sides(&q);
+    if (!interval_empty(&q.left)) return false;
+
+    if (t->lowpt[q.right.low] > t->lowpt[e]) { // Merge intervals
+      if (interval_empty(&p.right))
+        p.right = q.right;
+      else
+        set_ref(t, p.right.low, q.right.high);
+
+      p.right.low = q.right.low;
+    } else { // Align
+      set_ref(t, q.right.low, t->lowpt_edge[e]);
+    }
+  } while (t->top != t->stack_bottom[ei]);
+
+  // Merge the conflicting return edges of the preceding siblings into p.left
+
+  while (t->top > 0 && (conflicting(t, &t->S[t->top-1].left, ei)
+                     || conflicting(t, &t->S[t->top-1].right, ei))) {
+    struct conflict_pair q = t->S[--t->top];
+
+    if (conflicting(t, &q.right, ei)) swap_sides(&q);
+    if (conflicting(t, &q.right, ei)) return false;
+
+    // Merge the interval below lowpt(ei) into p.right
+    set_ref(t, p.right.low, q.right.high);
+    if (q.right.low != -1) p.right.low = q.right.low;
+
+    if (interval_empty(&p.left))
+      p.left = q.left;
+    else
+      set_ref(t, p.left.low, q.left.high);
+
+    p.left.low = q.left.low;
+  }
+
+  if (!interval_empty(&p.left) || !interval_empty(&p.right))
+    t->S[t->top++] = p;
+
+  return true;
+}
+
+// [Auxiliary] Removes the back edges that return to the tail of e from the
+// conflict pairs (once the subtree of e is done)
+
+static void remove_back_edges(struct lr *t, int e) {
+  int u = t->tail[e];
+
+  // Drop the conflict pairs that only return to u
+
+  while (t->top > 0 && lowest(t, &t->S[t->top-1]) == t->height[u]) {
+    struct conflict_pair *p = &t->S[--t->top];
+    if (p->left.low != -1) t->side[p->left.low] = -1;
+  }
+
+  // Trim the intervals of the next conflict pair
+
+  if (t->top > 0) {
+    struct conflict_pair *p = &t->S[t->top-1];
+
+    while (p->left.high != -1 && t->head[p->left.high] == u)
+      p->left.high = t->ref[p->left.high];
+
+    if (p->left.high == -1 && p->left.low != -1) { // Just emptied
+      t->ref[p->left.low] = p->right.low;
+      t->side[p->left.low] = -1;
+      p->left.low = -1;
+    }
+
+    while (p->right.high != -1 && t->head[p->right.high] == u)
+      p->right.high = t->ref[p->right.high];
+
+    if (p->right.high == -1 && p->right.low != -1) { // Just emptied
+      t->ref[p->right.low] = p->left.low;
+      t->side[p->right.low] = -1;
+      p->right.low = -1;
+    }
+  }
+
+  // The side of e is the side of its highest return edge
+
+  if (t->lowpt[e] < t->height[u] && t->top > 0) {
+    int hl = t->S[t->top-1].left.high, hr = t->S[t->top-1].right.high;
+
+    if (hl != -1 && (hr == -1 || t->lowpt[hl] > t->lowpt[hr]))
+      t->ref[e] = hl;
+    else
+      t->ref[e] = hr;
+  }
+}
+
+// [Auxiliary] Phase 2: tests the DFS tree rooted at root. Returns false if
+// the graph isn't planar
+
+static bool test(struct lr *t, int root) {
+  int sp = 0;
+  t->stack[sp++] = root;
+
+  while (sp > 0) {
+    int v = t->stack[--sp];
+    int e = t->parent_edge[v];
+    int start = t->offsets[v], end = start + t->n_out[v];
+    bool descended = false;
+
+    for ( ; t->ind[v] < end; t->ind[v]++) {
+      int ei = t->ordered[t->ind[v]], w = t->head[ei];
+
+      if (!t->skip[ei]) {
+        t->stack_bottom[ei] = t->top;
+
+        if (ei == t->parent_edge[w]) { // Tree edge: descend to w
+          t->skip[ei] = true;
+          t->stack[sp++] = v;
+          t->stack[sp++] = w;
+
+          descended = true;
+          break;
+        }
+
+        // Back edge
+        t->lowpt_edge[ei] = ei;
+        t->S[t->top++] = (struct conflict_pair) {{-1, -1}, {ei, ei}};
+      }
+
+      // Integrate the new return edges
+
+      if (t->lowpt[ei] < t->height[v]) {
+        if (t->ind[v] == start)
+          t->lowpt_edge[e] = t->lowpt_edge[ei];
+        else if (!add_constraints(t, ei, e))
+          return false;
+      }
+    }
+
+    if (!descended && e != -1) remove_back_edges(t, e);
+  }
+
+  return true;
+}
+
+// [Auxiliary] Resolves the side of a half-edge, by following its chain of
+// references (each reference flips the side if the referenced half-edge is
+// on the other side). Returns 1 or -1
+
+static int sign(struct lr *t, int e) {
+  int length = 0;
+
+  for ( ; t->ref[e] != -1; e = t->ref[e])
+    t->chain[length++] = e;
+
+  // e is the end of the chain, so its side is final
+
+  while (length > 0) {
+    int c = t->chain[--length];
+
+    t->side[c] *= t->side[e];
+    t->ref[c] = -1;
+    e = c;
+  }
+
+  return t->side[e];
+}
+
+// [Auxiliary] Inserts half-edge h in the rotation of v, right after ref in
+// clockwise order (ref is -1 if the rotation of v is empty)
+
+static void insert_cw(struct lr *t, int v, int h, int ref) {
+  if (ref == -1) {
+    t->cw[h] = t->ccw[h] = h;
+    t->first[v] = h;
+    return;
+  }
+
+  int next = t->cw[ref];
+
+  t->cw[ref] = h;
+  t->ccw[h] = ref;
+  t->cw[h] = next;
+  t->ccw[next] = h;
+}
+
+// [Auxiliary] Inserts half-edge h in the rotation of v, right before ref in
+// clockwise order (h becomes the first one, if ref was)
+
+static void insert_ccw(struct lr *t, int v, int h, int ref) {
+  if (ref == -1) {
+    insert_cw(t, v, h, -1);
+    return;
+  }
+
+  insert_cw(t, v, h, t->ccw[ref]);
+  if (ref == t->first[v]) t->first[v] = h;
+}
+
+// [Auxiliary] Phase 3: adds the half-edges into each vertex (the reverses
+// of the oriented ones) to the rotations, over the DFS tree rooted at root
+
+static void embed(struct lr *t, int root) {
+  int sp = 0;
+  t->stack[sp++] = root;
+
+  while (sp > 0) {
+    int v = t->stack[--sp];
+    int end = t->offsets[v] + t->n_out[v];
+
+    while (t->ind[v] < end) {
+      int ei = t->ordered[t->ind[v]++], w = t->head[ei];
+
+      if (ei == t->parent_edge[w]) { // Tree edge: descend to w
+        insert_ccw(t, w, t->twin[ei], t->first[w]);
+        t->first[w] = t->twin[ei];
+
+        t->left_ref[v] = t->right_ref[v] = ei;
+
+        t->stack[sp++] = v;
+        t->stack[sp++] = w;
+        break;
+      }
+
+      // Back edge: it goes on the side that the test picked for it
+
+      if (t->side[ei] == 1) {
+        insert_cw(t, w, t->twin[ei], t->right_ref[w]);
+      } else {
+        insert_ccw(t, w, t->twin[ei], t->left_ref[w]);
+        t->left_ref[w] = t->twin[ei];
+      }
+    }
+  }
+}
+
+// [Auxiliary] Runs the test (and, if embedding is true and the graph is
+// planar, computes the rotations). Returns true if the graph is planar
+
+static bool lr_run(struct lr *t, bool embedding) {
+
+  // A simple planar graph with n >= 3 vertices has at most 3n - 6 edges
+  if (t->n > 2 && t->m > 3 * t->n - 6) return false;
+
+  for (int v = 0; v < t->n; v++)
+    t->ind[v] = t->offsets[v];
+
+  for (int v = 0; v < t->n; v++)
+    if (t->height[v] == -1) {
+      t->roots[t->n_roots++] = v;
+      orient(t, v);
+    }
+
+  order_by_nesting_depth(t);
+
+  memset(t->skip, 0, sizeof(bool) * 2 * t->m);
+
+  for (int v = 0; v < t->n; v++)
+    t->ind[v] = t->offsets[v];
+
+  for (int r = 0; r < t->n_roots; r++)
+    if (!test(t, t->roots[r]))
+      return false;
+
+  if (!embedding) return true;
+
+  // The signed nesting depths give the final clockwise order of the
+  // oriented half-edges out of each vertex
+
+  for (int h = 0; h < 2 * t->m; h++)
+    if (t->oriented[h])
+      t->nesting_depth[h] *= sign(t, h);
+
+  order_by_nesting_depth(t);
+
+  for (int v = 0; v < t->n; v++) {
+    int *out = &t->ordered[t->offsets[v]];
+
+    t->first[v] = -1;
+
+    for (int i = 0; i < t->n_out[v]; i++)
+      insert_cw(t, v, out[i], (i == 0) ? -1 : out[i-1]);
+  }
+
+  for (int v = 0; v < t->n; v++)
+    t->ind[v] = t->offsets[v];
+
+  for (int r = 0; r < t->n_roots; r++)
+    embed(t, t->roots[r]);
+
+  return true;
+}
+
+// [Auxiliary] Returns true if the graph with n vertices and the m edges
+// (from[i], to[i]) is planar
+
+static bool is_planar(int n, int m, int *from, int *to) {
+  struct lr *t = lr_create(n, m, from, to);
+  bool planar = lr_run(t, false);
+
+  lr_destroy(t);
+  return planar;
+}
+
+// [Auxiliary] Stores the rotations of a planar graph in p, and counts the
+// faces of the embedding (each face is traced by repeatedly moving from
+// half-edge u -> v to the half-edge that follows v -> u around v)
+
+static void store_embedding(struct lr *t, struct planarity *p) {
+  p->offsets = alloc(t->n + 1, sizeof(int));
+  p->rotation = alloc(2 * t->m, sizeof(int));
+
+  memcpy(p->offsets, t->offsets, sizeof(int) * (t->n + 1));
+
+  for (int v = 0; v < t->n; v++) {
+    int i = t->offsets[v], h = t->first[v];
+    if (t->offsets[v+1] == t->offsets[v]) continue;
+
+    do {
+      p->rotation[i++] = t->head[h];
+      h = t->cw[h];
+    } while (h != t->first[v]);
+  }
+
+  bool *traced = alloc(2 * t->m, sizeof(bool));
+  p->n_faces = 0;
+
+  for (int h = 0; h < 2 * t->m; h++) {
+    if (traced[h]) continue;
+
+    p->n_faces++;
+
+    for (int e = h; !traced[e]; e = t->cw[t->twin[e]])
+      traced[e] = true;
+  }
+
+  free(traced);
+}
+
+// [Auxiliary] Stores in p a Kuratowski subgraph of the non-planar graph
+// with n vertices and the m edges (from[i], to[i]). Every edge that the
+// graph stays non-planar without is deleted, so what's left is a minimal
+// non-planar graph, i.e. a subdivision of K5 or K3,3
+
+static void store_witness(struct planarity *p, int n, int m, int *from,
+                          int *to) {
+  int *u = alloc(m, sizeof(int)), *v = alloc(m, sizeof(int));
+  int k = m;
+
+  memcpy(u, from, sizeof(int) * m);
+  memcpy(v, to, sizeof(int) * m);
+
+  // While there are more than 3n - 6 edges, any edge can go
+
+  if (n > 2 && k > 3 * n - 6) k = 3 * n - 5;
+
+  for (int i = k - 1; i >= 0; i--) {
+
+    // Try the graph without edge i (moved to the end of the arrays)
+
+    int eu = u[i], ev = v[i];
+
+    u[i] = u[k-1]; v[i] = v[k-1];
+    u[k-1] = eu; v[k-1] = ev;
+
+    if (!is_planar(n, k - 1, u, v)) {
+      k--; // Edge i isn't needed
+    } else {
+      u[k-1] = u[i]; v[k-1] = v[i]; // Put it back
+      u[i] = eu; v[i] = ev;
+    }
+  }
+
+  p->n_witness = k;
+  p->witness = alloc(2 * k, sizeof(int));
+
+  int *degree = alloc(n, sizeof(int));
+
+  for (int i = 0; i < k; i++) {
+    p->witness[2*i] = u[i];
+    p->witness[2*i+1] = v[i];
+
+    degree[u[i]]++;
+    degree[v[i]]++;
+  }
+
+  // K5 has 5 branch vertices (of degree 4), K3,3 has 6 (of degree 3)
+
+  int branch = 0;
+
+  for (int i = 0; i < n; i++)
+    if (degree[i] > 2) branch++;
+
+  p->k5 = (branch == 5);
+
+  free(degree);
+  free(u);
+  free(v);
+}
+
+// Tests whether a graph is planar. If it isn't and witness is true, a
+// Kuratowski subgraph is extracted too (which takes quadratic time, since
+// it's done by deleting every edge that the graph stays non-planar without)
+
+struct planarity * planarity_test(struct graph *g, bool witness) {
+  struct planarity *p = alloc(1, sizeof(struct planarity));
+
+  int *from, *to;
+  int m = graph_edges(g, &from, &to);
+
+  p->n_countries = g->n_countries;
+  p->n_edges = m;
+
+  struct lr *t = lr_create(g->n_countries, m, from, to);
+  p->planar = lr_run(t, true);
+
+  if (p->planar)
+    store_embedding(t, p);
+  else if (witness)
+    store_witness(p, g->n_countries, m, from, to);
+
+  lr_destroy(t);
+  free(from);
+  free(to);
+
+  return p;
+}
+
+// Destroys the result of a planarity test (memory deallocation)
+
+void planarity_destroy(struct planarity *p) {
+  free(p->offsets);
+  free(p->rotation);
+  free(p->witness);
+  free(p);
+}
+
+// The 5-coloring works by reduction (Matula, Shiloach and Tarjan): every
+// planar graph has a vertex v of degree at most 5. If its degree is at most
+// 4, v is removed, and it can be colored last, since its neighbours use at
+// most 4 colors. Otherwise, two of its neighbours, x and y, aren't adjacent
+// (or there would be a K6), so v is removed and y is merged into x, which
+// keeps the graph planar. Coloring y like x leaves v's neighbours with at
+// most 4 colors again. The reductions are recorded, and the colors are
+// assigned in reverse order.
+
+#define FIVE 5
+
+struct reduction {
+  int v;               // Removed vertex
+  int x, y;            // y was merged into x (or -1, if nothing was merged)
+  int nbrs[FIVE];      // Neighbours of v at the time of its removal
+  int n_nbrs;
+};
+
+struct reducer {
+  int n;
+  int *to;             // Head of each half-edge (h and h^1 are twins)
+  int *next, *prev;    // Half-edges out of the same vertex (-1: none)
+  int *first;          // First half-edge out of each vertex (-1: none)
+  int *degree;
+  bool *removed;
+  int *mark;           // mark[v] == stamp: v is a neighbour of the vertex
+  int stamp;           // being examined
+
+  int *low, n_low;     // Candidates of degree <= 4 (possibly stale)
+  int *five, n_five;   // Candidates of degree 5 (possibly stale)
+  int capacity;        // Capacity of both candidate stacks
+};
+
+// [Auxiliary] Pushes a vertex on the candidate stack that matches its
+// degree (if any). The stacks are grown as needed, since a vertex is
+// pushed whenever its degree drops
+
+static void push_candidate(struct reducer *r, int v) {
+  if (r->degree[v] > FIVE || r->removed[v]) return;
+
+  if (r->n_low == r->capacity || r->n_five == r->capacity) {
+    r->capacity *= 2;
+    r->low = realloc(r->low, sizeof(int) * r->capacity);
+    r->five = realloc(r->five, sizeof(int) * r->capacity);
+
+    if (r->low == NULL || r->five == NULL)
+      terminate("planar_five_color: out of memory");
+  }
+
+  if (r->degree[v] < FIVE)
+    r->low[r->n_low++] = v;
+  else
+    r->five[r->n_five++] = v;
+}
+
+// [Auxiliary] Unlinks half-edge h from the list of vertex u
+
+static void unlink_half_edge(struct reducer *r, int u, int h) {
+  if (r->prev[h] != -1) r->next[r->prev[h]] = r->next[h];
+  else r->first[u] = r->next[h];
+
+  if (r->next[h] != -1) r->prev[r->next[h]] = r->prev[h];
+  r->degree[u]--;
+}
+
+// [Auxiliary] Links half-edge h to the list of vertex u
+
+static void link_half_edge(struct reducer *r, int u, int h) {
+  r->prev[h] = -1;
+  r->next[h] = r->first[u];
+
+  if (r->first[u] != -1) r->prev[r->first[u]] = h;
+  r->first[u] = h;
+  r->degree[u]++;
+}
+
+// [Auxiliary] Removes a vertex (recording its neighbours in red)
+
+static void remove_vertex(struct reducer *r, int v, struct reduction *red) {
+  red->v = v;
+  red->n_nbrs = 0;
+
+  for (int h = r->first[v]; h != -1; h = r->next[h]) {
+    int w = r->to[h];
+
+    red->nbrs[red->n_nbrs++] = w;
+
+    unlink_half_edge(r, w, h ^ 1);
+    push_candidate(r, w);
+  }
+
+  r->first[v] = -1;
+  r->degree[v] = 0;
+  r->removed[v] = true;
+}
+
+// [Auxiliary] Merges vertex y into vertex x, dropping the edges that would
+// become duplicates (those of the common neighbours)
+
+static void merge(struct reducer *r, int x, int y) {
+  r->stamp++;
+
+  for (int h = r->first[x]; h != -1; h = r->next[h])
+    r->mark[r->to[h]] = r->stamp;
+
+  for (int h = r->first[y], next; h != -1; h = next) {
+    int z = r->to[h];
+    next = r->next[h];
+
+    if (r->mark[z] == r->stamp) {
+      unlink_half_edge(r, z, h ^ 1); // Common neighbour
+      push_candidate(r, z);
+    } else {
+      link_half_edge(r, x, h);
+      r->to[h ^ 1] = x;
+    }
+  }
+
+  r->first[y] = -1;
+  r->degree[y] = 0;
+  r->removed[y] = true;
+
+  push_candidate(r, x);
+}
+
+// [Auxiliary] Finds two neighbours of a degree 5 vertex v that aren't
+// adjacent, preferring the pair with the smallest total degree (so that
+// merging them is cheap). Returns false if there isn't such a pair
+
+static bool find_pair(struct reducer *r, int v, int *x, int *y) {
+  int nbrs[FIVE], n_nbrs = 0;
+  bool adjacent[FIVE][FIVE] = {{false}};
+
+  for (int h = r->first[v]; h != -1; h = r->next[h])
+    nbrs[n_nbrs++] = r->to[h];
+
+  // Mark the neighbours of v with their position, to find their adjacencies
+
+  for (int i = 0; i < n_nbrs; i++)
+    r->mark[nbrs[i]] = -(i + 1);
+
+  for (int i = 0; i < n_nbrs; i++)
+    for (int h = r->first[nbrs[i]]; h != -1; h = r->next[h])
+      if (r->mark[r->to[h]] < 0)
+        adjacent[i][-r->mark[r->to[h]] - 1] = true;
+
+  for (int i = 0; i < n_nbrs; i++)
+    r->mark[nbrs[i]] = 0;
+
+  int best = -1;
+
+  for (int i = 0; i < n_nbrs; i++)
+    for (int j = i + 1; j < n_nbrs; j++) {
+      int cost = r->degree[nbrs[i]] + r->degree[nbrs[j]];
+
+      if (!adjacent[i][j] && (best == -1 || cost < best)) {
+        best = cost;
+
+        // The vertex with fewer neighbours is merged into the other one
+        bool smaller = r->degree[nbrs[i]] < r->degree[nbrs[j]];
+
+        *x = smaller ? nbrs[j] : nbrs[i];
+        *y = smaller ? nbrs[i] : nbrs[j];
+      }
+    }
+
+  return best != -1;
+}
+
+// Colors a planar graph with 5 colors, ignoring its precolored countries
+// (color[v] is set to 0 ... 4 for every v). Returns false if the graph
+// turns out not to be planar, in which case color is left unspecified
+
+bool planar_five_color(struct graph *g, int *color) {
+  int n = g->n_countries;
+  int *from, *to;
+  int m = graph_edges(g, &from, &to);
+
+  struct reducer r = {.n = n, .stamp = 0, .n_low = 0, .n_five = 0};
+
+  r.to = alloc(2 * m, sizeof(int));
+  r.next = alloc(2 * m, sizeof(int));
+  r.prev = alloc(2 * m, sizeof(int));
+  r.first = alloc(n, sizeof(int));
+  r.degree = alloc(n, sizeof(int));
+  r.removed = alloc(n, sizeof(bool));
+  r.mark = alloc(n, sizeof(int));
+
+  r.capacity = n + 1;
+  r.low = alloc(r.capacity, sizeof(int));
+  r.five = alloc(r.capacity, sizeof(int));
+
+  for (int v = 0; v < n; v++)
+    r.first[v] = -1;
+
+  for (int i = 0; i < m; i++) {
+    r.to[2*i] = to[i];
+    r.to[2*i+1] = from[i];
+
+    link_half_edge(&r, from[i], 2*i);
+    link_half_edge(&r, to[i], 2*i+1);
+  }
+
+  free(from);
+  free(to);
+
+  // The vertices are pushed in reverse, so that they're reduced in order
+  for (int v = n - 1; v >= 0; v--)
+    push_candidate(&r, v);
+
+  struct reduction *reductions = alloc(n, sizeof(struct reduction));
+  int n_reductions = 0, left = n;
+  bool planar = true;
+
+  while (left > 0) {
+    int v = -1, x = -1, y = -1;
+
+    while (v == -1 && r.n_low > 0) {
+      int u = r.low[--r.n_low];
+      if (!r.removed[u] && r.degree[u] < FIVE) v = u;
+    }
+
+    while (v == -1 && r.n_five > 0) {
+      int u = r.five[--r.n_five];
+      if (!r.removed[u] && r.degree[u] == FIVE && find_pair(&r, u, &x, &y))
+        v = u;
+    }
+
+    if (v == -1) { // Every vertex has more than 5 neighbours
+      planar = false;
+      break;
+    }
+
+    struct reduction *red = &reductions[n_reductions++];
+
+    remove_vertex(&r, v, red);
+    red->x = x;
+    red->y = y;
+    left--;
+
+    if (x != -1) {
+      merge(&r, x, y);
+      left--;
+    }
+  }
+
+  // Color the vertices in reverse order of removal: at that point, the
+  // neighbours that v had when it was removed are colored, and x and y
+  // have the same color, so there are at most 4 colors to avoid
+
+  for (int i = n_reductions - 1; planar && i >= 0; i--) {
+    struct reduction *red = &reductions[i];
+    bool used[FIVE] = {false};
+
+    if (red->x != -1) color[red->y] = color[red->x];
+
+    for (int k = 0; k < red->n_nbrs; k++)
+      used[color[red->nbrs[k]]] = true;
+
+    color[red->v] = 0;
+    while (used[color[red->v]]) color[red->v]++;
+  }
+
+  free(reductions);
+  free(r.to); free(r.next); free(r.prev); free(r.first);
+  free(r.degree); free(r.removed); free(r.mark);
+  free(r.low); free(r.five);
+
+  return planar;
+}
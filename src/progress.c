@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "progress.h"
+
+// Set asynchronously (SIGALRM / SIGUSR1) when a progress report is due
+
+static volatile sig_atomic_t report_pending = 0;
+
+// Signal dispositions and timer that progress_start replaced, which
+// progress_stop puts back
+
+static struct sigaction old_alarm, old_usr1;
+static struct itimerval old_timer;
+
+// [Auxiliary] Signal handler that requests a progress report. The report
+// itself is printed by progress_check, since stdio isn't safe to use
+// inside a signal handler
+
+static void request_report(int signum) {
+  report_pending = 1;
+}
+
+// Requests a progress report every second, and whenever the process
+// receives SIGUSR1 (until progress_stop is called)
+
+void progress_start(void) {
+  report_pending = 0;
+
+  struct sigaction sa = {0};
+  sa.sa_handler = request_report;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+
+  sigaction(SIGALRM, &sa, &old_alarm);
+  sigaction(SIGUSR1, &sa, &old_usr1);
+
+  struct itimerval every_second = {{1, 0}, {1, 0}};
+  setitimer(ITIMER_REAL, &every_second, &old_timer);
+}
+
+// Stops the periodic progress reports, and restores the signal handlers
+// and the timer that were there before progress_start
+
+void progress_stop(void) {
+  setitimer(ITIMER_REAL, &old_timer, NULL);
+
+  sigaction(SIGALRM, &old_alarm, NULL);
+  sigaction(SIGUSR1, &old_usr1, NULL);
+}
+
+// Prints search statistics to stderr, prefixed with label
+
+void progress_print(char *label, const struct mapcol_stats *stats) {
+  fprintf(stderr, "[%s] elapsed: %.3fs, nodes: %ld, backtracks: %ld, "
+          "restarts: %ld, depth: %d (max: %d), first solution: ", label,
+          stats->elapsed, stats->nodes, stats->backtracks, stats->restarts,
+          stats->depth, stats->max_depth);
+
+  if (stats->first_solution < 0)
+    fprintf(stderr, "none yet\n");
+  else
+    fprintf(stderr, "%.3fs\n", stats->first_solution);
+
+  // Only the depths at which backtracking actually happened are printed
+
+  fprintf(stderr, "[%s] backtracks per depth:", label);
+
+  for (int d = 0; d < stats->histogram_size; d++)
+    if (stats->backtracks_at[d] > 0)
+      fprintf(stderr, " %d:%ld", d, stats->backtracks_at[d]);
+
+  fprintf(stderr, "\n");
+}
+
+// Prints a progress report if one has been requested (it's the progress
+// callback of the solves, see struct mapcol_options)
+
+void progress_check(const struct mapcol_stats *stats, void *arg) {
+  if (!report_pending) return;
+
+  report_pending = 0;
+  progress_print("progress", stats);
+}
@@ -0,0 +1,619 @@
+// Resident mode: the map and its coloring are kept in memory, and edits
+// are applied to them through commands, one per line:
+//
+// add <A> [<N>...]       : adds country A, which borders the countries N
+// border <A> <B>         : adds a border between countries A and B
+// unborder <A> <B>       : removes the border between countries A and B
+// paint <A> <color>      : A gets the given color, which won't be changed
+//                          by later repairs ("nocolor" lifts this)
+// split <A> <B> [<N>...] : country B is split off from A. B borders A, and
+//                          the listed neighbours of A now border B instead
+// print                  : prints the whole map
+// quit                   : stops the service
+//
+// After each edit, the coloring is repaired locally: the countries that
+// are in conflict (or uncolored) are recolored along with the countries
+// within distance r of them, where r = 0, 1, 2, ... until a coloring is
+// found (the rest of the map keeps its colors). Then, the countries whose
+// color changed are printed ("<color> <name>", like in the input format),
+// followed by a line that contains "ok". If the edit is rejected, a line
+// "error: <reason>" is printed instead, and if the map can't be repaired
+// (at all, or within the bounds below), the conflicting countries are left
+// uncolored and the response ends with "failed".
+//
+// Countries are looked up through a hash table and each country keeps an
+// array of its neighbours' indices, so the cost of an edit depends on the
+// size of the repaired region, not on the size of the map. The region is
+// bounded too: r stops at REPAIR_MAX_RADIUS, and the backtracking of a
+// repair (over all of its radii) stops after REPAIR_MAX_STEPS steps.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "utilities.h"
+#include "constants.h"
+#include "ADT_List.h"
+#include "color.h"
+#include "names.h"
+#include "serve.h"
+
+#define MAX_ARGS 512 // Maximum number of words in a command
+
+#define REPAIR_MAX_RADIUS 8         // Largest radius of a repair
+#define REPAIR_MAX_STEPS (1 << 16)  // Backtracking steps allowed per repair
+
+struct country {
+  int color;       // Index in the colors array (-1 if uncolored)
+  bool fixed;      // True for precolored & painted countries
+  int *neighbours; // Indices of the neighbouring countries
+  int degree;      // Number of neighbours
+  int capacity;    // Size of the neighbours array
+};
+
+struct service {
+  struct names *names;        // Country name -> index
+  struct country *countries;  // countries[i] is named names_get(names, i)
+  int n_countries;
+  int capacity;               // Size of the countries (and scratch) arrays
+
+  char **colors;              // Color names (the first n_colors are used)
+  int n_colors;
+  int max_colors;
+
+  // Scratch space for the repairs, allocated once (and grown along with
+  // the countries array) so that an edit doesn't cost O(n_countries)
+
+  int *mark;                  // mark[i] == stamp if i is in the region
+  int stamp;
+  int *region;                // Countries that are being recolored
+  int *old_colors;            // Their colors before the repair
+  int *seeds;                 // Countries that an edit left to recolor
+  int n_seeds;
+  long steps_left;            // Backtracking steps left to the repair
+};
+
+// [Auxiliary] Returns the index of a color name (-1 for "nocolor" and -2
+// for unknown colors)
+
+static int color_index(struct service *s, char *color) {
+  if (!strcmp(color, "nocolor")) return -1;
+
+  for (int i = 0; i < s->max_colors; i++)
+    if (!strcmp(s->colors[i], color))
+      return i;
+
+  return -2;
+}
+
+// [Auxiliary] Returns the name of a color index
+
+static char * color_name(struct service *s, int color) {
+  return (color < 0) ? "nocolor" : s->colors[color];
+}
+
+// [Auxiliary] Adds a new (uncolored) country and returns its index
+
+static int add_country(struct service *s, char *name) {
+  if (s->n_countries == s->capacity) {
+    s->capacity = (s->capacity == 0) ? 64 : 2 * s->capacity;
+
+    s->countries = realloc(s->countries, sizeof(struct country) * s->capacity);
+    s->mark = realloc(s->mark, sizeof(int) * s->capacity);
+    s->region = realloc(s->region, sizeof(int) * s->capacity);
+    s->old_colors = realloc(s->old_colors, sizeof(int) * s->capacity);
+    s->seeds = realloc(s->seeds, sizeof(int) * s->capacity);
+
+    if (s->countries == NULL || s->mark == NULL || s->region == NULL
+     || s->old_colors == NULL || s->seeds == NULL)
+      terminate("serve: out of memory");
+  }
+
+  int index = names_add(s->names, name);
+  if (index != s->n_countries) terminate("serve: out of memory");
+
+  struct country *c = &s->countries[s->n_countries++];
+  c->color = -1;
+  c->fixed = false;
+  c->neighbours = NULL;
+  c->degree = c->capacity = 0;
+
+  s->mark[index] = 0;
+
+  return index;
+}
+
+// [Auxiliary] Returns true if countries u and v are neighbours
+
+static bool are_neighbours(struct service *s, int u, int v) {
+  struct country *c = &s->countries[u];
+
+  for (int i = 0; i < c->degree; i++)
+    if (c->neighbours[i] == v)
+      return true;
+
+  return false;
+}
+
+// [Auxiliary] Adds v to the neighbours of u (one direction only)
+
+static void add_neighbour(struct service *s, int u, int v) {
+  struct country *c = &s->countries[u];
+
+  if (c->degree == c->capacity) {
+    c->capacity = (c->capacity == 0) ? 4 : 2 * c->capacity;
+
+    c->neighbours = realloc(c->neighbours, sizeof(int) * c->capacity);
+    if (c->neighbours == NULL) terminate("serve: out of memory");
+  }
+
+  c->neighbours[c->degree++] = v;
+}
+
+// [Auxiliary] Removes v from the neighbours of u (one direction only)
+
+static void remove_neighbour(struct service *s, int u, int v) {
+  struct country *c = &s->countries[u];
+
+  for (int i = 0; i < c->degree; i++) {
+    if (c->neighbours[i] == v) {
+      c->neighbours[i] = c->neighbours[--c->degree];
+      return;
+    }
+  }
+}
+
+// [Auxiliary] Adds a border between u and v (if there isn't one already)
+
+static void add_border(struct service *s, int u, int v) {
+  if (u == v || are_neighbours(s, u, v)) return;
+
+  add_neighbour(s, u, v);
+  add_neighbour(s, v, u);
+}
+
+// [Auxiliary] Returns true if country v can get the given color
+
+static bool can_take(struct service *s, int v, int color) {
+  struct country *c = &s->countries[v];
+
+  for (int i = 0; i < c->degree; i++)
+    if (s->countries[c->neighbours[i]].color == color)
+      return false;
+
+  return true;
+}
+
+// [Auxiliary] Stores in s->region the non-fixed countries within distance
+// radius of the seeds (in BFS order) and returns how many they are
+
+static int build_region(struct service *s, int *seeds, int n_seeds, int radius) {
+  int size = 0;
+  s->stamp++;
+
+  for (int i = 0; i < n_seeds; i++) {
+    if (s->mark[seeds[i]] == s->stamp || s->countries[seeds[i]].fixed)
+      continue;
+
+    s->mark[seeds[i]] = s->stamp;
+    s->region[size++] = seeds[i];
+  }
+
+  // Each iteration of the outer loop adds the countries of the next level
+  for (int level = 0, begin = 0; level < radius; level++) {
+    int end = size;
+
+    for (int i = begin; i < end; i++) {
+      struct country *c = &s->countries[s->region[i]];
+
+      for (int j = 0; j < c->degree; j++) {
+        int u = c->neighbours[j];
+
+        if (s->mark[u] == s->stamp || s->countries[u].fixed) continue;
+
+        s->mark[u] = s->stamp;
+        s->region[size++] = u;
+      }
+    }
+
+    if (end == size) break; // The region can't grow any further
+    begin = end;
+  }
+
+  return size;
+}
+
+// [Auxiliary] Colors the countries region[pos..size-1] by backtracking.
+// Each country tries its previous color first, to keep changes minimal.
+// Returns false if there's no such coloring, or if the repair runs out of
+// steps (see s->steps_left)
+
+static bool recolor(struct service *s, int pos, int size) {
+  if (pos == size) return true;
+  if (s->steps_left == 0) return false;
+
+  s->steps_left--;
+
+  int v = s->region[pos];
+  int previous = s->old_colors[pos];
+
+  for (int k = -1; k < s->n_colors; k++) {
+    int color = (k == -1) ? previous : k;
+    if (color < 0 || color >= s->n_colors || (k >= 0 && k == previous))
+      continue;
+
+    if (can_take(s, v, color)) {
+      s->countries[v].color = color;
+
+      if (recolor(s, pos + 1, size))
+        return true;
+
+      s->countries[v].color = -1;
+    }
+  }
+
+  return false;
+}
+
+// [Auxiliary] Repairs the coloring around the given seeds (the countries
+// that are uncolored or in conflict), printing the countries that changed.
+// Returns false if the map can't be repaired within REPAIR_MAX_RADIUS and
+// REPAIR_MAX_STEPS
+
+static bool repair(struct service *s, int *seeds, int n_seeds, FILE *out) {
+  int prev_size = -1;
+
+  s->steps_left = REPAIR_MAX_STEPS;
+
+  for (int radius = 0; radius <= REPAIR_MAX_RADIUS; radius++) {
+    int size = build_region(s, seeds, n_seeds, radius);
+
+    for (int i = 0; i < size; i++) {
+      s->old_colors[i] = s->countries[s->region[i]].color;
+      s->countries[s->region[i]].color = -1;
+    }
+
+    if (recolor(s, 0, size)) {
+      for (int i = 0; i < size; i++) {
+        int v = s->region[i];
+
+        if (s->countries[v].color != s->old_colors[i])
+          fprintf(out, "%s %s\n", color_name(s, s->countries[v].color),
+                  names_get(s->names, v));
+      }
+
+      return true;
+    }
+
+    for (int i = 0; i < size; i++)
+      s->countries[s->region[i]].color = s->old_colors[i];
+
+    if (size == prev_size) break; // Whole component tried, no coloring
+    if (s->steps_left == 0) break; // Out of steps
+    prev_size = size;
+  }
+
+  // Leave the seeds uncolored, so that the coloring stays valid
+  for (int i = 0; i < n_seeds; i++) {
+    struct country *c = &s->countries[seeds[i]];
+
+    if (!c->fixed && c->color != -1) {
+      c->color = -1;
+      fprintf(out, "nocolor %s\n", names_get(s->names, seeds[i]));
+    }
+  }
+
+  return false;
+}
+
+// [Auxiliary] Prints the whole map, in the input format
+
+static void print_map(struct service *s, FILE *out) {
+  for (int i = 0; i < s->n_countries; i++) {
+    struct country *c = &s->countries[i];
+
+    fprintf(out, "%s %s", color_name(s, c->color), names_get(s->names, i));
+
+    for (int j = 0; j < c->degree; j++)
+      fprintf(out, " %s", names_get(s->names, c->neighbours[j]));
+
+    fprintf(out, "\n");
+  }
+}
+
+// [Auxiliary] Looks up the countries named in args[0..n_args-1], storing
+// their indices in ids. Returns false if one of them doesn't exist
+
+static bool lookup(struct service *s, char **args, int n_args, int *ids) {
+  for (int i = 0; i < n_args; i++)
+    if ((ids[i] = names_find(s->names, args[i])) == -1)
+      return false;
+
+  return true;
+}
+
+// [Auxiliary] Adds a country to the seeds of a repair (the seeds never
+// outnumber the countries, unless a country is added twice, which is
+// harmless to leave out)
+
+static void add_seed(struct service *s, int country) {
+  if (s->n_seeds < s->capacity) s->seeds[s->n_seeds++] = country;
+}
+
+// [Auxiliary] Applies an edit command to the map and stores the countries
+// that must be recolored in s->seeds. Returns an error message if the
+// command is rejected (in which case the map is left as it was), or NULL
+
+static char * apply(struct service *s, char **args, int n_args, FILE *out) {
+  int ids[MAX_ARGS];
+  char *cmd = args[0];
+
+  s->n_seeds = 0;
+  args++, n_args--;
+
+  if (!strcmp(cmd, "add")) {
+    if (n_args < 1) return "usage: add <A> [<N>...]";
+    if (names_find(s->names, args[0]) != -1) return "country already exists";
+    if (!lookup(s, args + 1, n_args - 1, ids)) return "unknown country";
+
+    int a = add_country(s, args[0]);
+    for (int i = 0; i < n_args - 1; i++) add_border(s, a, ids[i]);
+
+    add_seed(s, a);
+  }
+  else if (!strcmp(cmd, "border")) {
+    if (n_args != 2) return "usage: border <A> <B>";
+    if (!lookup(s, args, 2, ids)) return "unknown country";
+    if (ids[0] == ids[1]) return "a country can't border itself";
+
+    struct country *a = &s->countries[ids[0]], *b = &s->countries[ids[1]];
+
+    if (a->color != -1 && a->color == b->color) {
+      if (a->fixed && b->fixed) return "both countries have the same fixed color";
+
+      // Recolor the country that's easier to recolor (the one that's not
+      // fixed and, if both aren't fixed, has fewer neighbours)
+
+      bool pick_a = !a->fixed && (b->fixed || a->degree <= b->degree);
+      add_seed(s, pick_a ? ids[0] : ids[1]);
+    }
+
+    add_border(s, ids[0], ids[1]);
+  }
+  else if (!strcmp(cmd, "unborder")) {
+    if (n_args != 2) return "usage: unborder <A> <B>";
+    if (!lookup(s, args, 2, ids)) return "unknown country";
+
+    // Removing a border can't make the coloring invalid
+    remove_neighbour(s, ids[0], ids[1]);
+    remove_neighbour(s, ids[1], ids[0]);
+  }
+  else if (!strcmp(cmd, "paint")) {
+    if (n_args != 2) return "usage: paint <A> <color>";
+    if (!lookup(s, args, 1, ids)) return "unknown country";
+
+    int color = color_index(s, args[1]);
+    if (color == -2 || color >= s->n_colors) return "unknown color";
+
+    struct country *a = &s->countries[ids[0]];
+
+    if (color == -1) { // The country's color is no longer fixed
+      a->fixed = false;
+      if (a->color == -1) add_seed(s, ids[0]);
+
+      return NULL;
+    }
+
+    for (int i = 0; i < a->degree; i++) {
+      struct country *b = &s->countries[a->neighbours[i]];
+
+      if (b->fixed && b->color == color)
+        return "a neighbour has the same fixed color";
+    }
+
+    for (int i = 0; i < a->degree; i++)
+      if (s->countries[a->neighbours[i]].color == color)
+        add_seed(s, a->neighbours[i]);
+
+    // The painted country is printed here, since repairs never touch it
+    if (a->color != color)
+      fprintf(out, "%s %s\n", args[1], args[0]);
+
+    a->color = color;
+    a->fixed = true;
+  }
+  else if (!strcmp(cmd, "split")) {
+    if (n_args < 2) return "usage: split <A> <B> [<N>...]";
+    if (!lookup(s, args, 1, ids)) return "unknown country";
+    if (names_find(s->names, args[1]) != -1) return "country already exists";
+    if (!lookup(s, args + 2, n_args - 2, ids + 1)) return "unknown country";
+
+    for (int i = 1; i < n_args - 1; i++)
+      if (!are_neighbours(s, ids[0], ids[i]))
+        return "not a neighbour of the split country";
+
+    int b = add_country(s, args[1]);
+    add_border(s, ids[0], b);
+
+    for (int i = 1; i < n_args - 1; i++) {
+      remove_neighbour(s, ids[0], ids[i]);
+      remove_neighbour(s, ids[i], ids[0]);
+      add_border(s, b, ids[i]);
+    }
+
+    add_seed(s, b);
+  }
+  else {
+    return "unknown command";
+  }
+
+  return NULL;
+}
+
+// [Auxiliary] Reads commands from "in" and writes the responses to "out",
+// until "in" is exhausted. Returns false if the "quit" command was given
+
+static bool session(struct service *s, FILE *in, FILE *out) {
+  char buf[4096]; // Line buffer (same as in read_map)
+  char *args[MAX_ARGS];
+
+  while (fgets(buf, sizeof(buf), in)) {
+    int n_args = 0;
+
+    for (char *word = strtok(buf, " \t\n"); word != NULL && n_args < MAX_ARGS;
+         word = strtok(NULL, " \t\n"))
+      args[n_args++] = word;
+
+    if (n_args == 0) continue;
+
+    if (!strcmp(args[0], "quit")) return false;
+
+    if (!strcmp(args[0], "print")) {
+      print_map(s, out);
+      fprintf(out, "ok\n");
+      fflush(out);
+      continue;
+    }
+
+    char *error = apply(s, args, n_args, out);
+
+    if (error != NULL)
+      fprintf(out, "error: %s\n", error);
+    else
+      fprintf(out, "%s\n",
+              repair(s, s->seeds, s->n_seeds, out) ? "ok" : "failed");
+
+    fflush(out);
+  }
+
+  return true;
+}
+
+// [Auxiliary] Serves the clients of a Unix socket (one at a time), until
+// one of them gives the "quit" command
+
+static void serve_socket(struct service *s, char *path) {
+  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server == -1) terminate("serve: cannot create socket");
+
+  struct sockaddr_un addr = {0};
+  addr.sun_family = AF_UNIX;
+
+  if (strlen(path) >= sizeof(addr.sun_path))
+    terminate("serve: socket path too long");
+
+  strcpy(addr.sun_path, path);
+  unlink(path);
+
+  // A client that disconnects while its reply is being written must not
+  // end the service (the write just fails instead)
+
+  signal(SIGPIPE, SIG_IGN);
+
+  if (bind(server, (struct sockaddr *) &addr, sizeof(addr)) == -1
+   || listen(server, 1) == -1)
+    terminate("serve: cannot listen on socket");
+
+  bool running = true;
+
+  while (running) {
+    int client = accept(server, NULL, NULL);
+    if (client == -1) continue;
+
+    FILE *in = fdopen(client, "r");
+    FILE *out = fdopen(dup(client), "w");
+
+    if (in == NULL || out == NULL) terminate("serve: out of memory");
+
+    running = session(s, in, out);
+
+    fclose(in);
+    fclose(out);
+  }
+
+  close(server);
+  unlink(path);
+}
+
+// Resident mode: colors the given (valid) map, then keeps the map and its
+// coloring in memory and applies edit commands to them, read from stdin
+// or, if options.socket_path is set, from the clients of a local Unix
+// socket. After each edit, the coloring is repaired locally around the
+// edited countries, and only the countries whose color changed are
+// printed (see above for the command protocol). Returns the exit status
+// of the program
+
+int serve(List *map, char **colors, int max_colors) {
+  struct service s = {0};
+
+  s.colors = colors;
+  s.n_colors = options.n_colors;
+  s.max_colors = max_colors;
+
+  if ((s.names = names_create()) == NULL) terminate("serve: out of memory");
+
+  // Countries that are colored in the input keep their colors
+
+  for (int i = 0; i < options.n_countries; i++) {
+    int index = add_country(&s, get_name(map, i));
+    if (index != i) terminate("Map is invalid (duplicate country)");
+
+    s.countries[i].fixed = !uncolored(map, i);
+  }
+
+  // The initial coloring is computed just like in the non-resident mode
+
+  List *non_sorted_map = map_copy(map);
+  sort_map(map);
+
+  bool colored = color_map(map, colors, options.n_colors);
+  free(non_sorted_map);
+
+  if (!colored) {
+    printf("The map cannot be colored with %d colors\n", options.n_colors);
+    names_destroy(s.names);
+    return EXIT_FAILURE;
+  }
+
+  // Now that the map is colored, keep its countries in integer form (the
+  // order of the map doesn't matter, since the names are looked up)
+
+  for (int i = 0; i < options.n_countries; i++) {
+    int v = names_find(s.names, get_name(map, i));
+
+    if ((s.countries[v].color = color_index(&s, get_color(map, i))) == -2)
+      terminate("serve: unknown color in the input map");
+
+    listNode curr = list_get_node(map[i], 2);
+
+    while (curr != list_end(map[i])) {
+      add_neighbour(&s, v, names_find(s.names, list_access(map[i], curr)));
+      curr = list_next(map[i], curr);
+    }
+  }
+
+  print_map(&s, stdout);
+  printf("ok\n");
+  fflush(stdout);
+
+  if (options.socket_path != NULL)
+    serve_socket(&s, options.socket_path);
+  else
+    session(&s, stdin, stdout);
+
+  for (int i = 0; i < s.n_countries; i++)
+    free(s.countries[i].neighbours);
+
+  free(s.countries);
+  free(s.mark);
+  free(s.region);
+  free(s.old_colors);
+  free(s.seeds);
+  names_destroy(s.names);
+
+  return 0;
+}
@@ -0,0 +1,755 @@
+// This file contains the solver of mapcol, as described in solve.h. The
+// search works as follows:
+//
+// for each country (in the order of the map):
+//   1. If it hasn't already been colored, color it with the first
+//      available color in the colors array. Otherwise, continue to
+//      the next country.
+//
+//   2. If such a color has been found (meaning that the country can
+//      be colored), and if, after it's been colored, there are no more
+//      countries to color, we're done and the map has been completely
+//      colored. Otherwise (if not all countries have been colored),
+//      color the rest of the map (i.e. jump to "for each country").
+//
+//   3. Otherwise, backtrack to the last country colored and choose a
+//      different color for it.
+//
+// The search works on the integer form of the map, where the available
+// colors of each country are kept as a bitset (its domain). A color is
+// also skipped if it would leave an uncolored neighbour with an empty
+// domain, since no solution can be reached that way.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fatal.h"
+#include "stats.h"
+#include "bitset.h"
+#include "solve.h"
+
+// The deadline is checked cooperatively by the search, once every
+// DEADLINE_CHECK_STEPS steps
+
+#define DEADLINE_CHECK_STEPS 256
+
+// State of a search over the integer form of a map. Each uncolored country
+// has a domain: a bitset of the colors that none of its neighbours has.
+// The domains are kept up to date incrementally, by counting how many
+// neighbours of each country have each color.
+//
+// Dense maps (at least DENSE_THRESHOLD of all possible borders) use the
+// dense engine instead, in which the neighbours of each country are a row
+// of a bit matrix, and each color has the bitset of the countries that
+// border it. Coloring a country then costs a few word-parallel operations
+// on rows, instead of a walk over hundreds of neighbours, and the domain
+// of a country is read off the color bitsets when it's needed
+
+#define DENSE_THRESHOLD 0.1
+
+struct search {
+  struct solve *solve; // Settings (and outcome) of the solve
+  struct graph *g;
+  int *perm;          // perm[i]: vertex of the i-th country (NULL: i itself)
+  int n_colors;       // Number of colors the search can use
+  int n_words;        // Number of words in each domain
+  int *order;         // Uncolored countries, in the order they're colored
+  int n_order;
+  int pos;            // Position (in the order) of the current country
+  bool started;       // False until search_run first gets to the search
+  uint64_t random;    // State of the random tie-breaking (restarts)
+  int n_forced;       // Countries colored by presolve (out of the order)
+  int *color;         // Color given to each country by the search (or -1)
+  int *conflicts;     // conflicts[v*n_colors + c]: v's neighbours colored c
+  uint64_t *domains;  // Domain of v: domains[v*n_words] ... (n_words words)
+
+  // Dense engine (conflicts isn't used, and the domains are only filled
+  // in when search_run gets to a country)
+
+  bool dense;
+  int n_row_words;     // Number of words in each row (and in each bitset)
+  uint64_t *rows;      // Neighbours of v: rows[v*n_row_words] ...
+  uint64_t *bordering; // Countries that border color c: bordering[c*n_row_words] ...
+  uint64_t *uncolored; // Countries that the search hasn't colored (yet)
+  uint64_t *trail;     // Previous bordering sets, undone in LIFO order
+  int n_trail;
+};
+
+// [Auxiliary] Returns the domain of a country
+
+static inline uint64_t * domain(struct search *s, int v) {
+  return &s->domains[(size_t) v * s->n_words];
+}
+
+// [Auxiliary] Dense engine: returns the row of v, the bitset of the
+// countries that border color c, and the trail entry at position i
+
+static inline uint64_t * row(struct search *s, int v) {
+  return &s->rows[(size_t) v * s->n_row_words];
+}
+
+static inline uint64_t * bordering(struct search *s, int c) {
+  return &s->bordering[(size_t) c * s->n_row_words];
+}
+
+static inline uint64_t * trail(struct search *s, int i) {
+  return &s->trail[(size_t) i * s->n_row_words];
+}
+
+// [Auxiliary] Dense engine: assign (see below)
+
+static bool dense_assign(struct search *s, int v, int c) {
+  int n_words = s->n_row_words;
+  uint64_t *neighbours = row(s, v), *border = bordering(s, c);
+
+  memcpy(trail(s, s->n_trail++), border, sizeof(uint64_t) * n_words);
+
+  bitset_or(border, border, neighbours, n_words);
+  bitset_clear(s->uncolored, v);
+
+  // An uncolored neighbour has no colors left if it borders every color
+
+  for (int i = 0; i < n_words; i++) {
+    uint64_t left = neighbours[i] & s->uncolored[i];
+
+    for (int k = 0; left != 0 && k < s->n_colors; k++)
+      left &= bordering(s, k)[i];
+
+    if (left != 0) return false;
+  }
+
+  return true;
+}
+
+// [Auxiliary] Dense engine: unassign (see below)
+
+static void dense_unassign(struct search *s, int v, int c) {
+  memcpy(bordering(s, c), trail(s, --s->n_trail),
+         sizeof(uint64_t) * s->n_row_words);
+
+  bitset_set(s->uncolored, v);
+}
+
+// [Auxiliary] Colors country v with color c, updating the domains of its
+// neighbours. Returns false if an uncolored neighbour is left without any
+// available colors (forward checking), in which case this color can't lead
+// to a solution (the assignment still has to be undone with unassign)
+
+static bool assign(struct search *s, int v, int c) {
+  if (s->dense) return dense_assign(s, v, c);
+
+  struct graph *g = s->g;
+  bool ok = true;
+
+  for (int i = g->offsets[v]; i < g->offsets[v+1]; i++) {
+    int u = g->adj[i];
+    if (u == v) continue;
+
+    if (s->conflicts[(size_t) u * s->n_colors + c]++ == 0) {
+      bitset_clear(domain(s, u), c);
+
+      if (s->color[u] == -1 && g->colors[u] == -1
+       && !bitset_any(domain(s, u), s->n_words))
+        ok = false;
+    }
+  }
+
+  return ok;
+}
+
+// [Auxiliary] Undoes assign(s, v, c)
+
+static void unassign(struct search *s, int v, int c) {
+  if (s->dense) {
+    dense_unassign(s, v, c);
+    return;
+  }
+
+  struct graph *g = s->g;
+
+  for (int i = g->offsets[v]; i < g->offsets[v+1]; i++) {
+    int u = g->adj[i];
+    if (u == v) continue;
+
+    if (--s->conflicts[(size_t) u * s->n_colors + c] == 0)
+      bitset_set(domain(s, u), c);
+  }
+}
+
+// [Auxiliary] Returns the domain of a country, as of now (the dense engine
+// computes it from the color bitsets)
+
+static uint64_t * current_domain(struct search *s, int v) {
+  uint64_t *dom = domain(s, v);
+  if (!s->dense) return dom;
+
+  bitset_fill(dom, s->n_words, s->n_colors);
+
+  for (int c = 0; c < s->n_colors; c++)
+    if (bitset_test(bordering(s, c), v))
+      bitset_clear(dom, c);
+
+  return dom;
+}
+
+// [Auxiliary] Returns the vertex of the i-th country of the map
+
+static inline int vertex(struct search *s, int i) {
+  return (s->perm != NULL) ? s->perm[i] : i;
+}
+
+// [Auxiliary] Copies the colors of the search to dst, in map order
+
+static void snapshot(struct search *s, int *dst) {
+  for (int i = 0; i < s->g->n_countries; i++)
+    dst[i] = s->color[vertex(s, i)];
+}
+
+// [Auxiliary] Dense engine: builds the bit matrix and the (empty) color
+// bitsets of a search
+
+static void dense_init(struct search *s) {
+  struct graph *g = s->g;
+  int n = g->n_countries, n_words = BITSET_WORDS(n);
+
+  s->n_row_words = n_words;
+  s->n_trail = 0;
+
+  // The trail holds one entry per uncolored country, plus one per
+  // precolored country (those entries are dropped once they're in)
+
+  s->rows = calloc((size_t) n * n_words + 1, sizeof(uint64_t));
+  s->bordering = calloc((size_t) s->n_colors * n_words + 1, sizeof(uint64_t));
+  s->uncolored = calloc(n_words + 1, sizeof(uint64_t));
+  s->trail = malloc(sizeof(uint64_t) * ((size_t) n * n_words + 1));
+
+  if (s->rows == NULL || s->bordering == NULL || s->uncolored == NULL
+   || s->trail == NULL)
+    terminate("solve_graph: out of memory");
+
+  for (int v = 0; v < n; v++) {
+    for (int i = g->offsets[v]; i < g->offsets[v+1]; i++)
+      if (g->adj[i] != v)
+        bitset_set(row(s, v), g->adj[i]);
+
+    if (g->colors[v] == -1) bitset_set(s->uncolored, v);
+  }
+}
+
+// [Auxiliary] Initializes a search over g for a solve. If perm isn't NULL,
+// the i-th country of the map is vertex perm[i] of g (the countries are
+// still colored in map order)
+
+static void search_init(struct search *s, struct solve *sv, struct graph *g,
+                        int *perm) {
+  int n = g->n_countries, n_colors = sv->n_colors;
+
+  // A country can always take one of the first (degree + 1) colors, so the
+  // search never gets to use more than (max. degree + 1) of them
+
+  int max_degree = 0;
+  for (int v = 0; v < n; v++)
+    if (graph_degree(g, v) > max_degree)
+      max_degree = graph_degree(g, v);
+
+  if (n_colors > max_degree + 1) n_colors = max_degree + 1;
+
+  s->solve = sv;
+  s->g = g;
+  s->perm = perm;
+  s->n_colors = n_colors;
+  s->n_words = BITSET_WORDS(n_colors);
+  s->n_order = 0;
+  s->n_forced = 0;
+  s->pos = 0;
+  s->started = false;
+  s->random = sv->seed;
+
+  s->dense = n > 1 && g->offsets[n] >= DENSE_THRESHOLD * n * (n - 1);
+
+  s->order = malloc(sizeof(int) * (n + 1));
+  s->color = malloc(sizeof(int) * (n + 1));
+  s->conflicts = s->dense ? NULL
+                          : calloc((size_t) n * n_colors + 1, sizeof(int));
+  s->domains = malloc(sizeof(uint64_t) * ((size_t) n * s->n_words + 1));
+
+  if (s->order == NULL || s->color == NULL || (!s->dense && s->conflicts == NULL)
+   || s->domains == NULL)
+    terminate("solve_graph: out of memory");
+
+  if (s->dense) dense_init(s);
+
+  for (int i = 0; i < n; i++) {
+    int v = vertex(s, i);
+
+    s->color[v] = -1;
+    bitset_fill(domain(s, v), s->n_words, n_colors);
+
+    if (g->colors[v] == -1) s->order[s->n_order++] = v;
+  }
+
+  // Precolored countries restrict the domains of their neighbours (colors
+  // that the search doesn't use can be ignored)
+
+  for (int v = 0; v < n; v++)
+    if (g->colors[v] >= 0 && g->colors[v] < n_colors)
+      assign(s, v, g->colors[v]);
+
+  s->n_trail = 0; // The precolored countries are never uncolored
+}
+
+// [Auxiliary] Returns a search that search_init hasn't set up yet (all of
+// its arrays are NULL, so that search_free can release it at any point)
+
+static struct search * search_create(void) {
+  struct search *s = calloc(1, sizeof(*s));
+  if (s == NULL) terminate("solve_graph: out of memory");
+
+  return s;
+}
+
+// [Auxiliary] Releases the memory used by a search
+
+static void search_free(struct search *s) {
+  free(s->order);
+  free(s->color);
+  free(s->conflicts);
+  free(s->domains);
+
+  if (s->dense) {
+    free(s->rows);
+    free(s->bordering);
+    free(s->uncolored);
+    free(s->trail);
+  }
+}
+
+// [Auxiliary] Returns the number of colors that a country can still take
+
+static inline int domain_size(struct search *s, int v) {
+  return bitset_popcount(current_domain(s, v), s->n_words);
+}
+
+// [Auxiliary] Returns true if a country is still uncolored
+
+static inline bool search_uncolored(struct search *s, int v) {
+  return s->color[v] == -1 && s->g->colors[v] == -1;
+}
+
+// [Auxiliary] Presolves a search, before any branching: every country that
+// can only take one color (given the precolored countries, which are
+// already out of the search order) is colored with it, and this is
+// repeated until no such country is left. The forced countries are then
+// removed from the search order. Returns -1 on success, or a country that
+// has no colors left (in which case the map can't be colored at all)
+
+static int presolve(struct search *s) {
+  struct graph *g = s->g;
+  int *queue = malloc(sizeof(int) * (g->n_countries + 1));
+  bool *queued = calloc(g->n_countries + 1, sizeof(bool));
+  int head = 0, tail = 0, empty = -1;
+
+  if (queue == NULL || queued == NULL) terminate("solve_graph: out of memory");
+
+  for (int i = 0; i < s->n_order && empty == -1; i++) {
+    int v = s->order[i], size = domain_size(s, v);
+
+    if (size == 0) empty = v;
+
+    if (size == 1) {
+      queue[tail++] = v;
+      queued[v] = true;
+    }
+  }
+
+  // Each country is queued at most once, when its domain shrinks to a
+  // single color
+
+  while (head < tail && empty == -1) {
+    int v = queue[head++];
+    int c = bitset_next(current_domain(s, v), s->n_words, 0);
+
+    assign(s, v, c);
+    s->color[v] = c;
+
+    for (int i = g->offsets[v]; i < g->offsets[v+1] && empty == -1; i++) {
+      int u = g->adj[i];
+      if (!search_uncolored(s, u)) continue;
+
+      int size = domain_size(s, u);
+
+      if (size == 0) empty = u;
+
+      if (size == 1 && !queued[u]) {
+        queue[tail++] = u;
+        queued[u] = true;
+      }
+    }
+  }
+
+  free(queue);
+  free(queued);
+
+  // The forced countries are never uncolored, so the dense engine doesn't
+  // have to be able to undo them
+
+  if (s->dense) s->n_trail = 0;
+
+  int n_order = 0;
+
+  for (int i = 0; i < s->n_order; i++)
+    if (s->color[s->order[i]] == -1)
+      s->order[n_order++] = s->order[i];
+
+  s->n_forced = s->n_order - n_order;
+  s->n_order = n_order;
+
+  return empty;
+}
+
+// The search restarts to avoid getting stuck below an early bad choice,
+// which is otherwise only undone once the whole subtree below it has been
+// searched. Restarting from scratch would throw away the progress of the
+// search, though, so the search in map order (the anchor) is only paused,
+// and it takes turns with a probe: a search that breaks the ties between
+// countries with the same number of neighbours at random (see --seed),
+// and starts over with a new random order on every turn. In turn i, the
+// anchor is given RESTART_UNIT * luby(i) backtracks, where luby(i) is 1,
+// 1, 2, 1, 1, 2, 4, 1, 1, 2, ... (Luby, Sinclair and Zuckerman), and the
+// probe is given half as many. The anchor keeps the search complete, and
+// its running time grows by about half at most, while the probes cut off
+// the long runs caused by unlucky orders. Maps that the anchor colors
+// within its first turn get the same coloring as without restarts.
+
+#define RESTART_UNIT 512
+
+enum outcome {
+  SOLVED,        // The map has been colored
+  UNSOLVABLE,    // There's no coloring at all
+  OUT_OF_TIME,   // The deadline has passed (the solve has expired)
+  OUT_OF_BUDGET  // The turn ran out of backtracks (the search is paused)
+};
+
+// [Auxiliary] Returns the i-th term of the Luby sequence (i >= 1)
+
+static long luby(long i) {
+  for (;;) {
+    int k = 1;
+    while ((1L << k) - 1 < i) k++;
+
+    if (i == (1L << k) - 1) return 1L << (k - 1);
+    i -= (1L << (k - 1)) - 1;
+  }
+}
+
+// [Auxiliary] Returns the next pseudorandom number of a search (splitmix64)
+
+static uint64_t next_random(struct search *s) {
+  uint64_t z = (s->random += 0x9E3779B97F4A7C15);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return z ^ (z >> 31);
+}
+
+// [Auxiliary] Sets the order of a search to the given one (which sort_map
+// sorted by number of neighbours), with each run of consecutive countries
+// that have the same number of neighbours shuffled
+
+static void shuffle_ties(struct search *s, int *order) {
+  memcpy(s->order, order, sizeof(int) * s->n_order);
+
+  for (int start = 0, end; start < s->n_order; start = end) {
+    int degree = graph_degree(s->g, s->order[start]);
+
+    for (end = start + 1; end < s->n_order; end++)
+      if (graph_degree(s->g, s->order[end]) != degree) break;
+
+    for (int i = end - 1; i > start; i--) {
+      int j = start + next_random(s) % (i - start + 1);
+      int temp = s->order[i];
+
+      s->order[i] = s->order[j];
+      s->order[j] = temp;
+    }
+  }
+}
+
+// [Auxiliary] Uncolors the countries that a paused search has colored (in
+// reverse order, which the dense engine needs), so that it can start over
+
+static void search_undo(struct search *s) {
+  int pos = s->pos;
+  if (pos == s->n_order || s->color[s->order[pos]] == -1) pos--;
+
+  for ( ; pos >= 0; pos--) {
+    int v = s->order[pos];
+
+    unassign(s, v, s->color[v]);
+    s->color[v] = -1;
+  }
+
+  s->pos = 0;
+  s->started = false;
+}
+
+// [Auxiliary] Colors the countries of the search order by backtracking,
+// pausing after the given number of backtracks (or never, if it's 0). A
+// paused search resumes where it left off
+
+static enum outcome search_run(struct search *s, long budget) {
+  int pos = s->pos; // Position (in the search order) of the current country
+  long steps = 0, backtracks = 0;
+  struct solve *sv = s->solve;
+
+  if (!s->started) {
+    s->started = true;
+    stats_enter();
+  } else {
+    stats.depth = pos + 1;
+  }
+
+  while (pos < s->n_order) {
+    if (sv->deadline > 0 && ++steps % DEADLINE_CHECK_STEPS == 0
+     && stats_now() >= sv->deadline) {
+      sv->expired = true;
+      return OUT_OF_TIME;
+    }
+
+    if (budget > 0 && backtracks >= budget) {
+      s->pos = pos;
+      return OUT_OF_BUDGET;
+    }
+
+    int v = s->order[pos];
+    int c = s->color[v];
+
+    // If the country already has a color, we came back to it because of
+    // backtracking, so the next available color is tried instead
+
+    if (c != -1) unassign(s, v, c);
+
+    uint64_t *dom = current_domain(s, v);
+
+    for (c = bitset_next(dom, s->n_words, c + 1); c != -1;
+         c = bitset_next(dom, s->n_words, c + 1)) {
+      if (assign(s, v, c)) break;
+      unassign(s, v, c); // A neighbour would be left without colors
+    }
+
+    s->color[v] = c;
+
+    if (c != -1) {
+      pos++;
+      stats_enter();
+
+      // Keep the deepest partial coloring, in case the deadline is reached
+      if (sv->best != NULL && pos > sv->best_pos) {
+        sv->best_pos = pos;
+        snapshot(s, sv->best);
+      }
+    } else {
+      stats_leave();
+      if (pos == 0) return UNSOLVABLE; // The first country couldn't be colored
+
+      pos--; // Backtrack
+      backtracks++;
+      stats_backtrack();
+    }
+  }
+
+  s->pos = pos;
+  stats_solution();
+
+  return SOLVED;
+}
+
+// [Auxiliary] Colors the countries of a (presolved) search, with the
+// anchor and the probes taking turns as described above. Returns true on
+// success, in which case the colors of the search are set, and false on
+// failure (or if the deadline has passed, in which case the solve has
+// expired)
+
+static bool search_solve(struct search *s, int *perm) {
+  struct solve *sv = s->solve;
+  enum outcome outcome = OUT_OF_BUDGET;
+
+  for (long turn = 1; outcome == OUT_OF_BUDGET; turn++) {
+    long budget = RESTART_UNIT * luby(turn);
+
+    outcome = search_run(s, budget);
+    if (outcome != OUT_OF_BUDGET) break;
+
+    // The probe is only set up if the anchor needs more than one turn
+
+    if (sv->probe == NULL) {
+      sv->probe = search_create();
+      search_init(sv->probe, sv, s->g, perm);
+      presolve(sv->probe);
+    } else {
+      search_undo(sv->probe);
+    }
+
+    stats_restart();
+    shuffle_ties(sv->probe, s->order);
+
+    outcome = search_run(sv->probe, budget / 2);
+
+    // The probe searches all of its tree if it has enough backtracks, so
+    // it can prove that there's no coloring too
+
+    if (outcome == SOLVED)
+      memcpy(s->color, sv->probe->color,
+             sizeof(int) * (s->g->n_countries + 1));
+  }
+
+  return outcome == SOLVED;
+}
+
+// [Auxiliary] Colors a graph without searching, if it's planar (every
+// planar graph can be colored with 5 colors, in linear time). Only graphs
+// without precolored vertices are colored this way. Returns true on success
+
+static bool planar_fast_path(struct solve *sv, struct graph *g) {
+  for (int i = 0; i < g->n_countries; i++)
+    if (g->colors[i] != -1) return false;
+
+  sv->planarity = planarity_test(g, sv->witness);
+
+  bool colored = sv->planarity->planar && planar_five_color(g, sv->color);
+  if (colored) stats_solution();
+
+  return colored;
+}
+
+// Sets up a solve with n_colors colors, no deadline, seed 0, and neither
+// renumbering nor witness
+
+void solve_init(struct solve *sv, int n_colors) {
+  sv->n_colors = n_colors;
+  sv->deadline = 0;
+  sv->seed = 0;
+  sv->renumber = false;
+  sv->witness = false;
+
+  sv->color = NULL;
+  sv->expired = false;
+  sv->best = NULL;
+  sv->best_pos = 0;
+  sv->bandwidth_before = sv->bandwidth_after = -1;
+  sv->planarity = NULL;
+  sv->width = -1;
+  sv->searched = false;
+  sv->n_precolored = sv->n_forced = sv->n_searched = 0;
+  sv->empty = -1;
+
+  sv->search = sv->probe = NULL;
+  sv->renumbered = NULL;
+  sv->perm = NULL;
+}
+
+// [Auxiliary] Releases the scratch memory of a solve
+
+static void release_scratch(struct solve *sv) {
+  if (sv->search != NULL) search_free(sv->search);
+  if (sv->probe != NULL) search_free(sv->probe);
+  if (sv->renumbered != NULL) graph_destroy(sv->renumbered);
+
+  free(sv->search);
+  free(sv->probe);
+  free(sv->perm);
+
+  sv->search = sv->probe = NULL;
+  sv->renumbered = NULL;
+  sv->perm = NULL;
+}
+
+// Colors the uncolored vertices of a graph (see graph.h) around its
+// precolored ones. Returns true on success, and false if there's no
+// coloring or the deadline has passed (sv->expired). Each struct solve is
+// used for one graph only
+
+bool solve_graph(struct solve *sv, struct graph *g) {
+  int n = g->n_countries;
+
+  sv->color = malloc(sizeof(int) * (n + 1));
+  if (sv->color == NULL) terminate("solve_graph: out of memory");
+
+  // With at least 5 colors, planar maps don't need the search at all
+
+  if (sv->n_colors >= 5 && planar_fast_path(sv, g)) return true;
+
+  // So do maps of small treewidth, with any number of colors
+
+  enum treedec_outcome outcome = treedec_color(g, sv->n_colors, sv->color,
+                                               &sv->width);
+
+  if (outcome != TREEDEC_TOO_WIDE) {
+    if (outcome == TREEDEC_COLORED) stats_solution();
+    return outcome == TREEDEC_COLORED;
+  }
+
+  // Renumbering the countries only changes where they're stored, not the
+  // order in which they're colored (so the coloring stays the same)
+
+  if (sv->renumber) {
+    sv->perm = graph_rcm(g);
+    sv->bandwidth_before = graph_bandwidth(g);
+
+    g = sv->renumbered = graph_renumber(g, sv->perm);
+    sv->bandwidth_after = graph_bandwidth(g);
+  }
+
+  struct search *s = sv->search = search_create();
+  search_init(s, sv, g, sv->perm);
+
+  int empty = presolve(s);
+
+  sv->searched = true;
+  sv->n_precolored = n - s->n_forced - s->n_order;
+  sv->n_forced = s->n_forced;
+  sv->n_searched = s->n_order;
+
+  for (int i = 0; empty != -1 && i < n; i++)
+    if (vertex(s, i) == empty) sv->empty = i;
+
+  // The partial coloring is only tracked if there's a deadline, since
+  // that's the only case in which it may have to be restored
+
+  if (sv->deadline > 0) {
+    sv->best = malloc(sizeof(int) * (n + 1));
+    if (sv->best == NULL) terminate("solve_graph: out of memory");
+
+    snapshot(s, sv->best);
+    sv->best_pos = 0;
+  }
+
+  bool colored = (empty == -1) && search_solve(s, sv->perm);
+  stats.depth = 0;
+
+  if (colored)
+    for (int i = 0; i < n; i++)
+      sv->color[i] = s->color[vertex(s, i)];
+
+  // The partial coloring is only needed if the search ran out of time
+  if (!sv->expired) {
+    free(sv->best);
+    sv->best = NULL;
+  }
+
+  release_scratch(sv);
+
+  return colored;
+}
+
+// Releases the memory used by a solve (including the scratch memory of a
+// solve_graph that didn't return)
+
+void solve_free(struct solve *sv) {
+  release_scratch(sv);
+
+  free(sv->color);
+  free(sv->best);
+
+  if (sv->planarity != NULL) planarity_destroy(sv->planarity);
+}
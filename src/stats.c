@@ -0,0 +1,46 @@
+#include <stdlib.h>
+#include <time.h>
+
+#include "fatal.h"
+#include "stats.h"
+
+_Thread_local struct search_stats stats;
+
+// Returns the time elapsed since an arbitrary fixed point (in seconds)
+
+double stats_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Resets the counters for a search over a map with n_countries countries,
+// and sets its progress callback (NULL: none)
+
+void stats_start(int n_countries, void (*progress)(void *arg), void *arg) {
+  stats_free();
+
+  // The search goes at most one level deeper than the number of countries
+  stats.histogram_size = n_countries + 2;
+  stats.backtracks_at = calloc(stats.histogram_size, sizeof(long));
+  if (stats.backtracks_at == NULL) terminate("stats_start: out of memory");
+
+  stats.nodes = stats.backtracks = stats.restarts = 0;
+  stats.depth = stats.max_depth = 0;
+  stats.first_solution = -1;
+  stats.start = stats_now();
+
+  stats.progress = progress;
+  stats.progress_arg = arg;
+}
+
+// Releases the memory used by the statistics
+
+void stats_free(void) {
+  free(stats.backtracks_at);
+
+  stats.backtracks_at = NULL;
+  stats.histogram_size = 0;
+  stats.progress = NULL;
+}
@@ -0,0 +1,1009 @@
+// This file contains the coloring of graphs of small treewidth, as
+// described in treedec.h.
+//
+// Eliminating a vertex joins its remaining neighbours to each other (they
+// become a clique), and the vertex forms a bag with them. The remaining
+// neighbours of v are its separator: the part of its bag shared with the
+// rest of the graph. The bag of v is a child of the bag of the first vertex
+// of its separator to be eliminated, which contains the whole separator of
+// v (since that's a clique by then). The width of the decomposition is the
+// size of the largest separator, and min-degree elimination (always taking
+// the vertex with the fewest remaining neighbours) keeps it low in practice.
+//
+// The table of a bag has one bit per coloring of its separator, encoded as
+// a number in base k (the number of colors): the bit is set if the vertex
+// and the vertices below it in the decomposition can be colored around
+// that coloring. The tables are filled in the order of elimination (the
+// children of a bag before it), and a coloring is then read off them in
+// the opposite order, from the roots down.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+
+#include "fatal.h"
+#include "bitset.h"
+#include "stats.h"
+#include "treedec.h"
+
+// The deadline of counting and enumerating is checked once every
+// DEADLINE_CHECK_STEPS steps
+
+#define DEADLINE_CHECK_STEPS 256
+
+struct neighbours {
+  int *v;
+  int size, capacity;
+};
+
+// Set of the edges of the graph (with the ones added by the elimination),
+// with open addressing. The key of edge (u, w), u < w, is (u << 32) | w,
+// which is never 0 (the empty slot)
+
+struct edge_set {
+  uint64_t *keys;
+  size_t capacity;   // A power of 2
+  size_t size;
+};
+
+struct decomposition {
+  int n;
+  int k;                // Number of colors
+  int limit;            // Largest separator allowed
+  int *fixed;           // Precolor of each vertex (-1: none, -2: a color
+                        // beyond the first k, which doesn't matter)
+  int *order;           // order[i]: i-th vertex to be eliminated
+  int *sep;             // Separator of v: sep[v*limit] ... (n_sep[v] vertices)
+  int *n_sep;
+  int *borders;         // Bit j of borders[v]: v must differ from sep[v][j]
+  int *where;           // Position of sep[v][j] in the bag of v's parent
+  int *first_child;     // Children of each bag (-1: none)
+  int *next_sibling;
+  uint64_t **tables;    // Table of each bag
+
+  // Counting: the table of v has a count per coloring of its separator,
+  // each one in limbs[v] 32-bit words (least significant first), enough
+  // for k to the power of size[v] (the uncolored vertices below v)
+
+  uint32_t **counts;
+  int *limbs;
+  int *size;
+
+  // Counting and enumerating give up once the deadline has passed (see
+  // stats_now, 0: no deadline)
+
+  double deadline;
+  long steps;
+  bool expired;
+};
+
+// [Auxiliary] Allocates a zeroed array of count elements of the given size
+
+static void * alloc(size_t count, size_t size) {
+  void *p = calloc(count + 1, size);
+  if (p == NULL) terminate("treedec: out of memory");
+
+  return p;
+}
+
+// [Auxiliary] Appends a vertex to a list of neighbours
+
+static void push(struct neighbours *list, int v) {
+  if (list->size == list->capacity) {
+    list->capacity = (list->capacity == 0) ? 4 : 2 * list->capacity;
+    list->v = realloc(list->v, sizeof(int) * list->capacity);
+    if (list->v == NULL) terminate("treedec: out of memory");
+  }
+
+  list->v[list->size++] = v;
+}
+
+// [Auxiliary] Returns the slot of an edge in an edge set (either the slot
+// that holds it, or the empty slot where it belongs)
+
+static size_t edge_slot(struct edge_set *set, uint64_t key) {
+  uint64_t h = key * 0x9e3779b97f4a7c15ULL;
+  size_t i = (h ^ (h >> 32)) & (set->capacity - 1);
+
+  while (set->keys[i] != 0 && set->keys[i] != key)
+    i = (i + 1) & (set->capacity - 1);
+
+  return i;
+}
+
+// [Auxiliary] Adds edge (u, w) to an edge set. Returns false if it was
+// already there
+
+static bool edge_insert(struct edge_set *set, int u, int w) {
+  if (u > w) { int t = u; u = w; w = t; }
+  uint64_t key = ((uint64_t) u << 32) | (uint64_t) w;
+
+  size_t i = edge_slot(set, key);
+  if (set->keys[i] == key) return false;
+
+  set->keys[i] = key;
+  set->size++;
+
+  // Keep the set at most half full
+
+  if (2 * set->size > set->capacity) {
+    uint64_t *old = set->keys;
+    size_t old_capacity = set->capacity;
+
+    set->capacity *= 2;
+    set->keys = alloc(set->capacity, sizeof(uint64_t));
+
+    for (size_t j = 0; j < old_capacity; j++)
+      if (old[j] != 0) set->keys[edge_slot(set, old[j])] = old[j];
+
+    free(old);
+  }
+
+  return true;
+}
+
+// [Auxiliary] Returns true if two vertices have to get different colors.
+// Countries colored with a color beyond the first k don't constrain the
+// others, and two precolored countries are left as they are
+
+static bool constrained(struct decomposition *d, int u, int w) {
+  if (u == w || d->fixed[u] == -2 || d->fixed[w] == -2) return false;
+
+  return d->fixed[u] == -1 || d->fixed[w] == -1;
+}
+
+// [Auxiliary] Returns the separator of a vertex
+
+static inline int * separator(struct decomposition *d, int v) {
+  return &d->sep[(size_t) v * d->limit];
+}
+
+// [Auxiliary] Computes a min-degree elimination order and the bags it
+// forms. Returns the width of the decomposition (which is above the limit
+// if it was given up, in which case the order is incomplete)
+
+static int eliminate(struct decomposition *d, struct graph *g) {
+  int n = d->n;
+
+  struct edge_set set = {NULL, 16, 0};
+  while (set.capacity < 2 * (size_t) g->offsets[n]) set.capacity *= 2;
+  set.keys = alloc(set.capacity, sizeof(uint64_t));
+
+  struct neighbours *adj = alloc(n, sizeof(struct neighbours));
+  int *degree = alloc(n, sizeof(int));
+  bool *eliminated = alloc(n, sizeof(bool));
+
+  // Vertices of each degree, as doubly linked lists (bucket queue)
+
+  int *head = alloc(n, sizeof(int));
+  int *next = alloc(n, sizeof(int));
+  int *prev = alloc(n, sizeof(int));
+
+  for (int v = 0; v < n; v++)
+    for (int i = g->offsets[v]; i < g->offsets[v+1]; i++) {
+      int u = g->adj[i];
+
+      if (constrained(d, v, u) && edge_insert(&set, v, u)) {
+        push(&adj[v], u);
+        push(&adj[u], v);
+        degree[v]++;
+        degree[u]++;
+      }
+    }
+
+  for (int i = 0; i <= n; i++) head[i] = -1;
+
+  for (int v = 0; v < n; v++) {
+    prev[v] = -1;
+    next[v] = head[degree[v]];
+    if (next[v] != -1) prev[next[v]] = v;
+    head[degree[v]] = v;
+  }
+
+  int width = 0, min = 0;
+
+  for (int i = 0; i < n; i++) {
+    while (head[min] == -1) min++;
+
+    if (min > width) width = min;
+    if (width > d->limit) break;
+
+    int v = head[min];
+    head[min] = next[v];
+    if (next[v] != -1) prev[next[v]] = -1;
+
+    eliminated[v] = true;
+    d->order[i] = v;
+
+    int *sep = separator(d, v), s = 0;
+
+    for (int j = 0; j < adj[v].size; j++)
+      if (!eliminated[adj[v].v[j]]) sep[s++] = adj[v].v[j];
+
+    d->n_sep[v] = s;
+
+    free(adj[v].v);
+    adj[v].v = NULL;
+
+    // The separator loses v and becomes a clique. Its vertices are taken
+    // out of their buckets while their degrees change
+
+    for (int j = 0; j < s; j++) {
+      int u = sep[j];
+
+      if (prev[u] != -1) next[prev[u]] = next[u];
+      else head[degree[u]] = next[u];
+      if (next[u] != -1) prev[next[u]] = prev[u];
+
+      degree[u]--;
+    }
+
+    for (int j = 0; j < s; j++)
+      for (int l = j + 1; l < s; l++)
+        if (edge_insert(&set, sep[j], sep[l])) {
+          push(&adj[sep[j]], sep[l]);
+          push(&adj[sep[l]], sep[j]);
+          degree[sep[j]]++;
+          degree[sep[l]]++;
+        }
+
+    for (int j = 0; j < s; j++) {
+      int u = sep[j];
+
+      prev[u] = -1;
+      next[u] = head[degree[u]];
+      if (next[u] != -1) prev[next[u]] = u;
+      head[degree[u]] = u;
+    }
+
+    // Each degree dropped by at most one
+    if (min > 0) min--;
+  }
+
+  for (int v = 0; v < n; v++) free(adj[v].v);
+
+  free(set.keys);
+  free(adj);
+  free(degree);
+  free(eliminated);
+  free(head);
+  free(next);
+  free(prev);
+
+  return width;
+}
+
+// [Auxiliary] Links each bag to its parent, and records the original
+// edges of each vertex to its separator
+
+static void link_bags(struct decomposition *d, struct graph *g) {
+  int n = d->n;
+  int *rank = alloc(n, sizeof(int));
+
+  for (int i = 0; i < n; i++) {
+    rank[d->order[i]] = i;
+    d->first_child[i] = -1;
+  }
+
+  for (int i = 0; i < n; i++) {
+    int v = d->order[i], *sep = separator(d, v);
+
+    for (int e = g->offsets[v]; e < g->offsets[v+1]; e++)
+      for (int j = 0; j < d->n_sep[v]; j++)
+        if (sep[j] == g->adj[e] && constrained(d, v, sep[j]))
+          d->borders[v] |= 1 << j;
+
+    if (d->n_sep[v] == 0) continue; // A root
+
+    int parent = sep[0];
+    for (int j = 1; j < d->n_sep[v]; j++)
+      if (rank[sep[j]] < rank[parent]) parent = sep[j];
+
+    // The bag of the parent is the parent itself (position 0), followed by
+    // its separator (positions 1 ...)
+
+    int *psep = separator(d, parent);
+
+    for (int j = 0; j < d->n_sep[v]; j++) {
+      int pos = 0;
+
+      if (sep[j] != parent)
+        while (psep[pos] != sep[j]) pos++;
+
+      d->where[(size_t) v * d->limit + j] = (sep[j] == parent) ? 0 : pos + 1;
+    }
+
+    d->next_sibling[v] = d->first_child[parent];
+    d->first_child[parent] = v;
+  }
+
+  free(rank);
+}
+
+// [Auxiliary] Returns the number of colorings of s vertices
+
+static int n_states(struct decomposition *d, int s) {
+  int states = 1;
+  for (int j = 0; j < s; j++) states *= d->k;
+
+  return states;
+}
+
+// [Auxiliary] Returns true if v can take color c, as far as its own
+// precolor and its neighbours in its separator (whose colors are in
+// bag[1] ...) are concerned
+
+static bool fits(struct decomposition *d, int v, int *bag, int c) {
+  if (d->fixed[v] >= 0 && c != d->fixed[v]) return false;
+  if (d->fixed[v] == -2 && c != 0) return false; // Any color is the same
+
+  for (int j = 0; j < d->n_sep[v]; j++)
+    if ((d->borders[v] >> j & 1) && bag[j+1] == c) return false;
+
+  return true;
+}
+
+// [Auxiliary] Returns the coloring of the separator of a bag (as an index
+// in its table), given the colors of the bag of its parent
+
+static int child_state(struct decomposition *d, int child, int *bag) {
+  int *where = &d->where[(size_t) child * d->limit];
+  int x = 0;
+
+  for (int j = d->n_sep[child] - 1; j >= 0; j--)
+    x = x * d->k + bag[where[j]];
+
+  return x;
+}
+
+// [Auxiliary] Returns true if v can take color c, given the colors of its
+// separator in bag[1] ... (bag[0] is set to c): it has to fit, and each
+// child bag has to be colorable around the colors of its separator
+
+static bool allowed(struct decomposition *d, int v, int *bag, int c) {
+  if (!fits(d, v, bag, c)) return false;
+
+  bag[0] = c;
+
+  for (int child = d->first_child[v]; child != -1;
+       child = d->next_sibling[child])
+    if (!bitset_test(d->tables[child], child_state(d, child, bag)))
+      return false;
+
+  return true;
+}
+
+// [Auxiliary] Fills in the table of a bag (the tables of its children have
+// to be filled in already)
+
+static void fill_table(struct decomposition *d, int v) {
+  int s = d->n_sep[v], states = n_states(d, s);
+
+  d->tables[v] = alloc(BITSET_WORDS(states), sizeof(uint64_t));
+
+  int bag[TREEDEC_MAX_WIDTH + 1] = {0};
+
+  for (int x = 0; x < states; x++) {
+    for (int c = 0; c < d->k; c++)
+      if (allowed(d, v, bag, c)) {
+        bitset_set(d->tables[v], x);
+        break;
+      }
+
+    // Next coloring of the separator (sep[0] is the least significant digit)
+    for (int j = 1; j <= s && ++bag[j] == d->k; j++) bag[j] = 0;
+  }
+}
+
+// Returns the largest width of a decomposition for n_colors colors (wider
+// ones are given up)
+
+int treedec_limit(int n_colors) {
+  int limit = 0;
+
+  for (int states = n_colors;
+       limit < TREEDEC_MAX_WIDTH && states <= TREEDEC_MAX_STATES;
+       states *= n_colors)
+    limit++;
+
+  return limit;
+}
+
+// [Auxiliary] Builds the decomposition of a graph for k colors. Returns
+// false if it's too wide, in which case *width is set to the largest width
+// allowed plus one (and otherwise, to the width of the decomposition)
+
+static bool decompose(struct decomposition *d, struct graph *g, int k,
+                      int *width) {
+  int n = g->n_countries;
+
+  d->n = n;
+  d->k = k;
+  d->limit = treedec_limit(k);
+
+  d->fixed = alloc(n, sizeof(int));
+  d->order = alloc(n, sizeof(int));
+  d->sep = alloc((size_t) n * d->limit, sizeof(int));
+  d->n_sep = alloc(n, sizeof(int));
+  d->borders = d->where = d->first_child = d->next_sibling = NULL;
+  d->tables = NULL;
+  d->counts = NULL;
+  d->limbs = d->size = NULL;
+  d->deadline = 0;
+  d->steps = 0;
+  d->expired = false;
+
+  for (int v = 0; v < n; v++)
+    if (g->colors[v] == -1) d->fixed[v] = -1;
+    else d->fixed[v] = (g->colors[v] >= 0 && g->colors[v] < k) ? g->colors[v]
+                                                                : -2;
+
+  *width = eliminate(d, g);
+
+  if (*width > d->limit) {
+    *width = d->limit + 1;
+    return false;
+  }
+
+  d->borders = alloc(n, sizeof(int));
+  d->where = alloc((size_t) n * d->limit, sizeof(int));
+  d->first_child = alloc(n, sizeof(int));
+  d->next_sibling = alloc(n, sizeof(int));
+
+  link_bags(d, g);
+  return true;
+}
+
+// [Auxiliary] Releases the memory used by a decomposition
+
+static void decomposition_free(struct decomposition *d) {
+  for (int v = 0; v < d->n; v++) {
+    if (d->tables != NULL) free(d->tables[v]);
+    if (d->counts != NULL) free(d->counts[v]);
+  }
+
+  free(d->fixed);
+  free(d->order);
+  free(d->sep);
+  free(d->n_sep);
+  free(d->borders);
+  free(d->where);
+  free(d->first_child);
+  free(d->next_sibling);
+  free(d->tables);
+  free(d->counts);
+  free(d->limbs);
+  free(d->size);
+}
+
+// Colors the uncolored countries of a graph with colors 0 ... n_colors-1,
+// around its precolored ones (color[v] is set for every uncolored v). The
+// width of the decomposition is stored in *width (or the largest width
+// allowed plus one, if the decomposition was given up)
+
+enum treedec_outcome treedec_color(struct graph *g, int n_colors, int *color,
+                                   int *width) {
+  struct decomposition d;
+  int n = g->n_countries;
+
+  // As in the search, no more than (max. degree + 1) colors are ever needed
+
+  int max_degree = 0;
+  for (int v = 0; v < n; v++)
+    if (graph_degree(g, v) > max_degree)
+      max_degree = graph_degree(g, v);
+
+  int k = (n_colors > max_degree + 1) ? max_degree + 1 : n_colors;
+
+  enum treedec_outcome outcome = TREEDEC_TOO_WIDE;
+
+  if (decompose(&d, g, k, width)) {
+    d.tables = alloc(n, sizeof(uint64_t *));
+
+    for (int i = 0; i < n; i++)
+      fill_table(&d, d.order[i]);
+
+    // The graph can be colored if every root's table has its only bit set
+
+    outcome = TREEDEC_COLORED;
+
+    for (int v = 0; v < n; v++)
+      if (d.n_sep[v] == 0 && !bitset_test(d.tables[v], 0))
+        outcome = TREEDEC_UNCOLORABLE;
+
+    // From the roots down, every vertex gets the first color that its
+    // table allows (there's one, since its separator is colored already)
+
+    int bag[TREEDEC_MAX_WIDTH + 1];
+
+    for (int i = n - 1; outcome == TREEDEC_COLORED && i >= 0; i--) {
+      int v = d.order[i], *sep = separator(&d, v);
+
+      for (int j = 0; j < d.n_sep[v]; j++)
+        bag[j+1] = color[sep[j]];
+
+      color[v] = 0;
+      while (!allowed(&d, v, bag, color[v])) color[v]++;
+    }
+  }
+
+  decomposition_free(&d);
+  return outcome;
+}
+
+// [Auxiliary] Returns the number of significant limbs of a number
+
+static int length(const uint32_t *a, int limbs) {
+  while (limbs > 0 && a[limbs-1] == 0) limbs--;
+  return limbs;
+}
+
+// [Auxiliary] Returns the number of limbs that k to the power of size fits in
+
+static int count_limbs(struct decomposition *d, int size) {
+  int bits = 1;
+  while ((1 << bits) < d->k) bits++;
+
+  return size * bits / 32 + 1;
+}
+
+// [Auxiliary] Adds b to a (both of the given number of limbs)
+
+static void add(uint32_t *a, const uint32_t *b, int limbs) {
+  uint64_t carry = 0;
+
+  for (int i = 0; i < limbs; i++) {
+    carry += (uint64_t) a[i] + b[i];
+    a[i] = (uint32_t) carry;
+    carry >>= 32;
+  }
+}
+
+// [Auxiliary] Multiplies a by b, in place. The product has to fit in the
+// limbs of a, and so does scratch
+
+static void multiply(uint32_t *a, int a_limbs, const uint32_t *b, int b_limbs,
+                     uint32_t *scratch) {
+  int la = length(a, a_limbs), lb = length(b, b_limbs);
+
+  memset(scratch, 0, sizeof(uint32_t) * a_limbs);
+
+  for (int i = 0; i < la; i++) {
+    uint64_t carry = 0;
+
+    for (int j = 0; j < lb && i + j < a_limbs; j++) {
+      uint64_t t = (uint64_t) a[i] * b[j] + scratch[i+j] + carry;
+      scratch[i+j] = (uint32_t) t;
+      carry = t >> 32;
+    }
+
+    if (i + lb < a_limbs) scratch[i+lb] = (uint32_t) carry;
+  }
+
+  memcpy(a, scratch, sizeof(uint32_t) * a_limbs);
+}
+
+// [Auxiliary] Returns the decimal digits of a number (which is destroyed
+// in the process). The caller has to free them
+
+static char * decimal(uint32_t *a, int limbs) {
+  char *digits = alloc((size_t) limbs * 10 + 1, sizeof(char));
+  int n_digits = 0, len = length(a, limbs);
+
+  do {
+    uint64_t rem = 0;
+
+    for (int i = len - 1; i >= 0; i--) {
+      uint64_t cur = (rem << 32) | a[i];
+      a[i] = (uint32_t) (cur / 10);
+      rem = cur % 10;
+    }
+
+    digits[n_digits++] = '0' + rem;
+    len = length(a, len);
+  } while (len > 0);
+
+  for (int i = 0; i < n_digits / 2; i++) {
+    char t = digits[i];
+    digits[i] = digits[n_digits-1-i];
+    digits[n_digits-1-i] = t;
+  }
+
+  return digits;
+}
+
+// [Auxiliary] Fills in the counts of a bag (the counts of its children
+// have to be filled in already, and they're released afterwards)
+
+static void count_table(struct decomposition *d, int v) {
+  int s = d->n_sep[v], states = n_states(d, s);
+
+  d->size[v] = (d->fixed[v] == -1) ? 1 : 0;
+
+  for (int child = d->first_child[v]; child != -1;
+       child = d->next_sibling[child])
+    d->size[v] += d->size[child];
+
+  int limbs = d->limbs[v] = count_limbs(d, d->size[v]);
+
+  d->counts[v] = alloc((size_t) states * limbs, sizeof(uint32_t));
+
+  uint32_t *product = alloc(limbs, sizeof(uint32_t));
+  uint32_t *scratch = alloc(limbs, sizeof(uint32_t));
+
+  int bag[TREEDEC_MAX_WIDTH + 1] = {0};
+
+  for (int x = 0; x < states; x++) {
+    uint32_t *count = &d->counts[v][(size_t) x * limbs];
+
+    // The subtrees of the children only share the bag, so for each color
+    // of v, their counts multiply
+
+    for (int c = 0; c < d->k; c++) {
+      if (!fits(d, v, bag, c)) continue;
+
+      bag[0] = c;
+      memset(product, 0, sizeof(uint32_t) * limbs);
+      product[0] = 1;
+
+      for (int child = d->first_child[v]; child != -1;
+           child = d->next_sibling[child]) {
+        size_t y = (size_t) child_state(d, child, bag) * d->limbs[child];
+        multiply(product, limbs, &d->counts[child][y], d->limbs[child], scratch);
+      }
+
+      add(count, product, limbs);
+    }
+
+    for (int j = 1; j <= s && ++bag[j] == d->k; j++) bag[j] = 0;
+  }
+
+  for (int child = d->first_child[v]; child != -1;
+       child = d->next_sibling[child]) {
+    free(d->counts[child]);
+    d->counts[child] = NULL;
+  }
+
+  free(product);
+  free(scratch);
+}
+
+// [Auxiliary] Counts a step of a count or an enumeration. Returns true if
+// its deadline has passed (checked once every DEADLINE_CHECK_STEPS steps)
+
+static bool out_of_time(struct decomposition *d) {
+  if (d->deadline > 0 && ++d->steps % DEADLINE_CHECK_STEPS == 0
+   && stats_now() >= d->deadline)
+    d->expired = true;
+
+  return d->expired;
+}
+
+// Decompositions that are too wide fall back to backtracking: the uncolored
+// vertices are colored one by one (those of a connected component next to
+// each other, in BFS order), with forward checking. Unlike the tables, the
+// search may run into dead ends, and it takes time proportional to the
+// number of colorings (which is why it's bounded by the deadline)
+
+struct backtrack {
+  struct decomposition *d;
+  struct graph *g;
+  int *order;        // Uncolored vertices, component by component
+  int *start;        // Component i: order[start[i]] ... order[start[i+1]-1]
+  int n_components;
+  int *color;        // Color of each vertex (-1: none yet)
+  int *conflicts;    // conflicts[v*k + c]: neighbours of v colored c
+  int *n_free;       // Number of colors that v can still take
+  void (*visit)(int *, void *);
+  void *arg;
+};
+
+// [Auxiliary] Colors v with c (or undoes it, if step is -1), updating the
+// colors that its uncolored neighbours can take. Returns false if one of
+// them is left without any
+
+static bool backtrack_assign(struct backtrack *b, int v, int c, int step) {
+  struct graph *g = b->g;
+  int k = b->d->k;
+  bool ok = true;
+
+  for (int i = g->offsets[v]; i < g->offsets[v+1]; i++) {
+    int u = g->adj[i];
+    if (b->color[u] != -1 || !constrained(b->d, u, v)) continue;
+
+    int *conflicts = &b->conflicts[(size_t) u * k + c];
+
+    if (step == 1 && (*conflicts)++ == 0 && --b->n_free[u] == 0) ok = false;
+    if (step == -1 && --(*conflicts) == 0) b->n_free[u]++;
+  }
+
+  return ok;
+}
+
+// [Auxiliary] Colors the vertices order[i] ... order[end-1] in every way
+// (calling visit for each coloring, if it's set), until limit colorings
+// are found or the deadline passes. Returns the number of colorings found
+
+static long backtrack_from(struct backtrack *b, int i, int end, long limit) {
+  if (out_of_time(b->d)) return 0;
+
+  if (i == end) {
+    if (b->visit != NULL) b->visit(b->color, b->arg);
+    return 1;
+  }
+
+  int v = b->order[i], k = b->d->k;
+  long found = 0;
+
+  for (int c = 0; c < k && found < limit; c++) {
+    if (b->conflicts[(size_t) v * k + c] != 0) continue;
+
+    b->color[v] = c;
+
+    if (backtrack_assign(b, v, c, 1))
+      found += backtrack_from(b, i + 1, end, limit - found);
+
+    backtrack_assign(b, v, c, -1);
+    b->color[v] = -1;
+  }
+
+  return found;
+}
+
+// [Auxiliary] Sets up the backtracking over the uncolored vertices of a
+// graph. Returns false if one of them can't take any color at all
+
+static bool backtrack_init(struct backtrack *b, struct decomposition *d,
+                           struct graph *g) {
+  int n = g->n_countries, k = d->k;
+
+  b->d = d;
+  b->g = g;
+  b->order = alloc(n, sizeof(int));
+  b->start = alloc(n + 1, sizeof(int));
+  b->n_components = 0;
+  b->color = alloc(n, sizeof(int));
+  b->conflicts = alloc((size_t) n * k, sizeof(int));
+  b->n_free = alloc(n, sizeof(int));
+  b->visit = NULL;
+
+  for (int v = 0; v < n; v++) {
+    b->color[v] = (d->fixed[v] == -1) ? -1 : d->fixed[v];
+    b->n_free[v] = k;
+  }
+
+  bool ok = true;
+
+  for (int v = 0; v < n; v++)
+    if (d->fixed[v] >= 0 && !backtrack_assign(b, v, d->fixed[v], 1))
+      ok = false;
+
+  // The components (of the uncolored vertices), in BFS order. The queue is
+  // the order itself, and color -3 marks the vertices already in it
+
+  int n_order = 0;
+
+  for (int r = 0; r < n; r++) {
+    if (b->color[r] != -1) continue;
+
+    b->start[b->n_components++] = n_order;
+    b->order[n_order++] = r;
+    b->color[r] = -3;
+
+    for (int head = n_order - 1; head < n_order; head++) {
+      int v = b->order[head];
+
+      for (int i = g->offsets[v]; i < g->offsets[v+1]; i++)
+        if (b->color[g->adj[i]] == -1) {
+          b->order[n_order++] = g->adj[i];
+          b->color[g->adj[i]] = -3;
+        }
+    }
+  }
+
+  b->start[b->n_components] = n_order;
+
+  for (int i = 0; i < n_order; i++)
+    b->color[b->order[i]] = -1;
+
+  return ok;
+}
+
+// [Auxiliary] Releases the memory used by a backtracking
+
+static void backtrack_free(struct backtrack *b) {
+  free(b->order);
+  free(b->start);
+  free(b->color);
+  free(b->conflicts);
+  free(b->n_free);
+}
+
+// [Auxiliary] Counts the colorings of a graph that's too wide for the
+// tables by backtracking, one connected component at a time (their counts
+// multiply). Returns the count as a decimal number (NULL if the deadline
+// passed first)
+
+static char * backtrack_count(struct decomposition *d, struct graph *g) {
+  struct backtrack b;
+  bool ok = backtrack_init(&b, d, g);
+
+  // Each component's count fits in 64 bits (two limbs), since every one of
+  // its colorings is reached on its own
+
+  int limbs = 2 * b.n_components + 1;
+  uint32_t *total = alloc(limbs, sizeof(uint32_t));
+  uint32_t *scratch = alloc(limbs, sizeof(uint32_t));
+
+  total[0] = ok;
+
+  for (int i = 0; ok && i < b.n_components; i++) {
+    uint64_t found = backtrack_from(&b, b.start[i], b.start[i+1], LONG_MAX);
+    uint32_t count[2] = {(uint32_t) found, (uint32_t) (found >> 32)};
+
+    multiply(total, limbs, count, 2, scratch);
+    ok = found != 0;
+  }
+
+  char *count = d->expired ? NULL : decimal(total, limbs);
+
+  free(total);
+  free(scratch);
+  backtrack_free(&b);
+
+  return count;
+}
+
+// [Auxiliary] Calls visit(color, arg) for every coloring of a graph that's
+// too wide for the tables, as soon as backtracking finds it (until the
+// deadline passes). Returns the number of colorings found
+
+static long backtrack_enumerate(struct decomposition *d, struct graph *g,
+                                void (*visit)(int *, void *), void *arg) {
+  struct backtrack b;
+  bool ok = backtrack_init(&b, d, g);
+
+  // A component without colorings would otherwise be searched again for
+  // every coloring of the ones before it
+
+  for (int i = 0; ok && i < b.n_components; i++)
+    ok = backtrack_from(&b, b.start[i], b.start[i+1], 1) == 1;
+
+  long found = 0;
+
+  if (ok && !d->expired) {
+    b.visit = visit;
+    b.arg = arg;
+    found = backtrack_from(&b, 0, b.start[b.n_components], LONG_MAX);
+  }
+
+  backtrack_free(&b);
+  return found;
+}
+
+// Counts the colorings of the uncolored countries of a graph with colors
+// 0 ... n_colors-1, around its precolored ones. Returns the count as a
+// decimal number (which the caller has to free). If the decomposition is
+// too wide (see *width, which is set as in treedec_color), they're counted
+// by backtracking instead, which gives up once the deadline has passed
+// (see stats_now, 0: no deadline) and returns NULL
+
+char * treedec_count(struct graph *g, int n_colors, int *width,
+                     double deadline) {
+  struct decomposition d;
+  int n = g->n_countries;
+  char *count = NULL;
+
+  if (!decompose(&d, g, n_colors, width)) {
+    d.deadline = deadline;
+    count = backtrack_count(&d, g);
+  } else {
+    d.counts = alloc(n, sizeof(uint32_t *));
+    d.limbs = alloc(n, sizeof(int));
+    d.size = alloc(n, sizeof(int));
+
+    for (int i = 0; i < n; i++)
+      count_table(&d, d.order[i]);
+
+    // Each root is a connected component of the graph (which shares no
+    // vertex with the others), so the count is the product of their counts
+
+    int size = 0;
+
+    for (int v = 0; v < n; v++)
+      if (d.n_sep[v] == 0) size += d.size[v];
+
+    int limbs = count_limbs(&d, size);
+    uint32_t *total = alloc(limbs, sizeof(uint32_t));
+    uint32_t *scratch = alloc(limbs, sizeof(uint32_t));
+
+    total[0] = 1;
+
+    for (int v = 0; v < n; v++)
+      if (d.n_sep[v] == 0)
+        multiply(total, limbs, d.counts[v], d.limbs[v], scratch);
+
+    count = decimal(total, limbs);
+
+    free(total);
+    free(scratch);
+  }
+
+  decomposition_free(&d);
+  return count;
+}
+
+// [Auxiliary] Colors the vertices order[i], order[i-1] ... in every way
+// that the tables allow, and calls visit for each complete coloring (until
+// the deadline passes). Returns the number of colorings found (the tables
+// only allow colors that lead to one, so no branch is a dead end)
+
+static long enumerate_from(struct decomposition *d, int i, int *color,
+                           void (*visit)(int *, void *), void *arg) {
+  if (i < 0) {
+    visit(color, arg);
+    return 1;
+  }
+
+  int v = d->order[i], *sep = separator(d, v);
+  int bag[TREEDEC_MAX_WIDTH + 1];
+  long found = 0;
+
+  for (int j = 0; j < d->n_sep[v]; j++)
+    bag[j+1] = color[sep[j]];
+
+  for (int c = 0; c < d->k && !out_of_time(d); c++)
+    if (allowed(d, v, bag, c)) {
+      color[v] = c;
+      found += enumerate_from(d, i - 1, color, visit, arg);
+    }
+
+  return found;
+}
+
+// Calls visit(color, arg) for every coloring of the uncolored countries
+// of a graph with colors 0 ... n_colors-1, around its precolored ones
+// (color[v] is set for every uncolored v), as soon as it's found, until
+// the deadline passes (see stats_now, 0: no deadline, and *expired is set
+// if it did). Returns the number of colorings found. If the decomposition
+// is too wide (see *width, which is set as in treedec_color), they're
+// found by backtracking instead
+
+long treedec_enumerate(struct graph *g, int n_colors,
+                       void (*visit)(int *color, void *arg), void *arg,
+                       int *width, double deadline, bool *expired) {
+  struct decomposition d;
+  int n = g->n_countries;
+  long found = 0;
+
+  bool wide = !decompose(&d, g, n_colors, width);
+  d.deadline = deadline;
+
+  if (wide)
+    found = backtrack_enumerate(&d, g, visit, arg);
+  else {
+    d.tables = alloc(n, sizeof(uint64_t *));
+
+    for (int i = 0; i < n; i++)
+      fill_table(&d, d.order[i]);
+
+    bool colorable = true;
+
+    for (int v = 0; v < n; v++)
+      if (d.n_sep[v] == 0 && !bitset_test(d.tables[v], 0))
+        colorable = false;
+
+    if (colorable) {
+      int *color = alloc(n, sizeof(int));
+
+      found = enumerate_from(&d, n - 1, color, visit, arg);
+      free(color);
+    }
+  }
+
+  *expired = d.expired;
+
+  decomposition_free(&d);
+  return found;
+}
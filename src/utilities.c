@@ -1,6 +1,8 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <ctype.h>
+#include <unistd.h>
 
 #include "constants.h"
 #include "ADT_List.h"
@@ -12,11 +14,61 @@
 // -i <file> : <file> becomes the input stream
 // -c : program only checks if input map is colored correctly
 // -n <num> : specifies how many colors can be used to color input map
+// -p <file> : the names of the colors are read from <file>
+// --stats : search statistics are reported to stderr (periodically, on
+//           SIGUSR1 and at the end of the run)
+// --witness : with --stats, a map that the planarity test finds to be
+//             non-planar is reported along with its Kuratowski subgraph
+//             (which takes quadratic time, unlike the rest of --stats)
+// --phases : the wall and CPU time of each phase is reported to stderr
+// --perf : same as --phases, but hardware counters are recorded as well
+// --timeout <sec> : the search gives up after <sec> seconds, and the deepest
+//                   partial coloring it found is printed instead (a count or
+//                   an enumeration that backtracks is cut short)
+// --batch [<file>...] : many maps are colored, either from the given files
+//                       or from the input stream (separated by blank lines)
+// --jobs <num> : number of worker threads used in batch mode
+// --serve : resident mode, the map is kept in memory and edit commands
+//           are read from stdin (see serve.c)
+// --socket <path> : same as --serve, but the commands are read from the
+//                   clients of a Unix socket that's created at <path>
+// --cache <dir> : colorings are stored in (and looked up from) a cache in
+//                 <dir>, keyed by a hash of the map that doesn't depend on
+//                 the order of the lines or the names of the countries
+// --renumber : the countries are renumbered for memory locality (reverse
+//              Cuthill-McKee) before the search, and the bandwidth of the
+//              numbering before and after that is reported to stderr (maps
+//              that the planar or tree decomposition fast path colors are
+//              never searched, so they aren't renumbered either)
+// --seed <num> : seed of the random tie-breaking that the search uses when
+//                it restarts (it only affects the restarts: maps that are
+//                colored by a fast path, or before the first restart, get
+//                the same coloring whatever the seed)
+// --count : the number of colorings of the map (that leave its precolored
+//           countries as they are) is printed, instead of one of them
+// --enumerate : every coloring of the map is printed, one after the other
 
 void process_CLA(int argc, char **argv) {
   options.input_file  = stdin;
   options.c_activated = false;
   options.n_colors    = 4;
+  options.palette_path = NULL;
+  options.stats       = false;
+  options.phases      = false;
+  options.perf        = false;
+  options.timeout     = 0;
+  options.batch       = false;
+  options.n_jobs      = sysconf(_SC_NPROCESSORS_ONLN);
+  options.files       = NULL;
+  options.n_files     = 0;
+  options.serve       = false;
+  options.socket_path = NULL;
+  options.cache_dir   = NULL;
+  options.renumber    = false;
+  options.seed        = 0;
+  options.count       = false;
+  options.enumerate   = false;
+  options.witness     = false;
 
   int argind; // current program argument index
 
@@ -46,36 +98,132 @@ void process_CLA(int argc, char **argv) {
         options.n_colors = atoi(argv[argind]);
         break;
 
+      case 'p':
+        if ((options.palette_path = argv[++argind]) == NULL)
+          terminate("Invalid program arguments");
+
+        break;
+
+      case '-': // Long options
+        if (!strcmp(argv[argind], "--stats"))
+          options.stats = true;
+        else if (!strcmp(argv[argind], "--witness"))
+          options.witness = true;
+        else if (!strcmp(argv[argind], "--phases"))
+          options.phases = true;
+        else if (!strcmp(argv[argind], "--perf"))
+          options.phases = options.perf = true;
+        else if (!strcmp(argv[argind], "--timeout")) {
+          if (argv[++argind] == NULL)
+            terminate("Invalid program arguments");
+
+          char *end;
+          options.timeout = strtod(argv[argind], &end);
+
+          if (*end != '\0' || end == argv[argind] || options.timeout <= 0)
+            terminate("Invalid program arguments");
+        }
+        else if (!strcmp(argv[argind], "--serve"))
+          options.serve = true;
+        else if (!strcmp(argv[argind], "--socket")) {
+          if ((options.socket_path = argv[++argind]) == NULL)
+            terminate("Invalid program arguments");
+
+          options.serve = true;
+        }
+        else if (!strcmp(argv[argind], "--cache")) {
+          if ((options.cache_dir = argv[++argind]) == NULL)
+            terminate("Invalid program arguments");
+        }
+        else if (!strcmp(argv[argind], "--renumber"))
+          options.renumber = true;
+        else if (!strcmp(argv[argind], "--seed")) {
+          if (argv[++argind] == NULL || argv[argind][0] == '\0')
+            terminate("Invalid program arguments");
+
+          for (int i = 0; argv[argind][i] != '\0'; i++)
+            if (!isdigit(argv[argind][i]))
+              terminate("Invalid program arguments");
+
+          options.seed = strtoul(argv[argind], NULL, 10);
+        }
+        else if (!strcmp(argv[argind], "--count"))
+          options.count = true;
+        else if (!strcmp(argv[argind], "--enumerate"))
+          options.enumerate = true;
+        else if (!strcmp(argv[argind], "--batch"))
+          options.batch = true;
+        else if (!strcmp(argv[argind], "--jobs")) {
+          if (argv[++argind] == NULL)
+            terminate("Invalid program arguments");
+
+          for (int i = 0; argv[argind][i] != '\0'; i++)
+            if (!isdigit(argv[argind][i]))
+              terminate("Invalid program arguments");
+
+          if ((options.n_jobs = atoi(argv[argind])) <= 0)
+            terminate("Invalid program arguments");
+        }
+        else
+          terminate("Invalid program arguments");
+
+        break;
+
       default:
         terminate("Invalid program arguments");
     }
   }
 
-  // Takes care of option arguments not starting with a dash ('-')
-  if (argind < argc) terminate("Invalid program arguments");
+  // Takes care of option arguments not starting with a dash ('-'), which
+  // are only allowed in batch mode (they're the input files)
+
+  if (argind < argc && !options.batch)
+    terminate("Invalid program arguments");
+
+  options.files = &argv[argind];
+  options.n_files = argc - argind;
+
+  if (options.n_jobs <= 0) options.n_jobs = 1;
 }
 
-// Prints msg and terminates the program
+// Prints msg and terminates the program (the fatal error handler of the
+// programs, see fatal.h)
 
-void terminate(char *msg) {
+void exit_on_fatal(char *msg) {
   fprintf(stderr, "%s\n", msg);
   exit(EXIT_FAILURE);
 }
 
-// Deallocates the map description list
+// Returns an array of MAX_COUNTRIES empty lists, in which a map
+// description can be stored (see read_map_into)
 
-void cleanup(List *map) {
-  for (int i = 0; i < MAX_COUNTRIES; i++) {
-    listNode curr = list_begin(map[i]);
+List * map_create(void) {
+  List *map = malloc(sizeof(List) * MAX_COUNTRIES);
+  if (map == NULL) terminate("map_create: out of memory");
 
-    // Deallocate memory for all the words in the current list
-    while (curr != list_end(map[i])) {
-      free(list_access(map[i], curr));
-      curr = list_next(map[i], curr);
-    }
+  for (int i = 0; i < MAX_COUNTRIES; i++)
+    if ((map[i] = list_create()) == NIL_LIST)
+      terminate("map_create: out of memory");
+
+  return map;
+}
+
+// Empties the map description list, so that it can be reused for
+// another map (the lists themselves are kept)
+
+void map_reset(List *map) {
+  for (int i = 0; i < options.n_countries; i++)
+    list_clear(map[i]);
+
+  options.n_countries = 0;
+}
 
+// Deallocates the map description list
+
+void cleanup(List *map) {
+  // The lists deallocate the words they contain themselves
+  for (int i = 0; i < MAX_COUNTRIES; i++)
     list_destroy(map[i]);
-  }
 
   free(map);
 }
@@ -0,0 +1,378 @@
+// Test of libmapcol (see libmapcol.h): several threads solve, count and
+// enumerate maps at the same time, each one on its own handles, and every
+// result has to be the one that the same call gives when it runs alone
+// (the solver is deterministic), and counts that would take too long have
+// to be cut short by their timeout. It's run by "make test", and "make test
+// SANITIZE=thread" checks the library for data races on the way.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "libmapcol.h"
+
+#define N_THREADS 8
+#define N_ROUNDS 3
+
+// A test map, the calls that are made on it, and their results when they
+// run alone
+
+struct test_map {
+  char *name;
+  int n, n_edges;
+  int *from, *to;
+  bool by_name;          // Build the handle country by country, by name
+  int precolored;        // Country precolored with color 0 (-1: none)
+  struct mapcol_options options;
+  int count_colors;      // Colors that the colorings are counted with
+  int enumerate_colors;  // Same, for the enumeration (0: neither)
+
+  enum mapcol_status status;
+  int *colors;
+  char *count;
+  long n_colorings;
+  long checksum;         // Checksum of the enumerated colorings
+};
+
+#define N_MAPS 4
+
+static struct test_map maps[N_MAPS];
+
+// Result of the calls of a thread
+
+struct worker {
+  pthread_t thread;
+  int index;
+  int failures;
+  long progress_calls;   // Calls to the progress callback of its solves
+};
+
+// A checksum of the colorings of an enumeration
+
+struct checksum {
+  int n;
+  long sum;
+};
+
+// [Auxiliary] Ends the test if memory can't be allocated
+
+static void * test_alloc(size_t size) {
+  void *p = malloc(size + 1);
+
+  if (p == NULL) {
+    fprintf(stderr, "concurrent: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  return p;
+}
+
+// [Auxiliary] Sets up a test map of n countries, with room for max_edges
+// borders (it's solved with the default options, and not counted)
+
+static void new_map(struct test_map *t, char *name, int n, int max_edges) {
+  memset(t, 0, sizeof(*t));
+
+  t->name = name;
+  t->n = n;
+  t->from = test_alloc(sizeof(int) * max_edges);
+  t->to = test_alloc(sizeof(int) * max_edges);
+  t->precolored = -1;
+
+  mapcol_default_options(&t->options);
+}
+
+// [Auxiliary] Adds a border to a test map
+
+static void add_edge(struct test_map *t, int a, int b) {
+  t->from[t->n_edges] = a;
+  t->to[t->n_edges++] = b;
+}
+
+// [Auxiliary] Sets up a triangulated grid of w x h countries (planar)
+
+static void make_grid(struct test_map *t, char *name, int w, int h) {
+  new_map(t, name, w * h, 3 * w * h);
+
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++) {
+      if (x + 1 < w) add_edge(t, y*w + x, y*w + x + 1);
+      if (y + 1 < h) add_edge(t, y*w + x, (y+1)*w + x);
+      if (x + 1 < w && y + 1 < h) add_edge(t, y*w + x, (y+1)*w + x + 1);
+    }
+}
+
+// [Auxiliary] Sets up the test maps, so that every path of the solver is
+// taken: the planarity test (a narrow grid with 5 colors), the search (a
+// wider grid by name, precolored, with 4 colors, and a dense random map),
+// and both the dynamic programming (the narrow grid) and the backtracking
+// (the wider grid, and a complete map) of the counts and enumerations
+
+static void make_maps(void) {
+  make_grid(&maps[0], "narrow grid", 40, 3);
+  maps[0].options.n_colors = 5;
+  maps[0].options.witness = true;
+  maps[0].count_colors = 5;
+
+  make_grid(&maps[1], "wide grid by name", 30, 20);
+  maps[1].by_name = true;
+  maps[1].precolored = 0;
+  maps[1].count_colors = 3;
+
+  struct test_map *t = &maps[2];
+  unsigned state = 1;
+
+  new_map(t, "random", 120, 120 * 119 / 2);
+
+  for (int a = 0; a < t->n; a++)
+    for (int b = a + 1; b < t->n; b++) {
+      state = state * 1103515245 + 12345;
+      if ((state >> 16) % 100 < 10) add_edge(t, a, b);
+    }
+
+  t->precolored = 3;
+  t->options.n_colors = 7;
+  t->options.renumber = true;
+  t->options.seed = 7;
+
+  t = &maps[3];
+  new_map(t, "complete", 8, 8 * 7 / 2);
+
+  for (int a = 0; a < t->n; a++)
+    for (int b = a + 1; b < t->n; b++)
+      add_edge(t, a, b);
+
+  t->options.n_colors = 8;
+  t->count_colors = 9;
+  t->enumerate_colors = 8;
+}
+
+// [Auxiliary] Returns a handle for a test map
+
+static struct mapcol * build(struct test_map *t) {
+  struct mapcol *m;
+
+  if (!t->by_name) {
+    m = mapcol_from_edges(t->n, t->n_edges, t->from, t->to);
+  } else if ((m = mapcol_create()) != NULL) {
+    char country[16], neighbour[16];
+    const char *neighbours[] = {neighbour};
+
+    // The countries are added in order first, so that they keep their
+    // indices, and then each border is listed by one of its countries
+
+    for (int v = 0; v < t->n; v++) {
+      sprintf(country, "c%d", v);
+      mapcol_country(m, country);
+    }
+
+    for (int i = 0; i < t->n_edges; i++) {
+      sprintf(country, "c%d", t->from[i]);
+      sprintf(neighbour, "c%d", t->to[i]);
+      mapcol_add(m, country, neighbours, 1);
+    }
+  }
+
+  if (m == NULL || mapcol_size(m) != t->n) {
+    fprintf(stderr, "concurrent: %s: the map can't be built\n", t->name);
+    exit(EXIT_FAILURE);
+  }
+
+  if (t->precolored != -1) mapcol_precolor(m, t->precolored, 0);
+
+  return m;
+}
+
+// [Auxiliary] Adds a coloring of an enumeration to its checksum
+
+static void add_coloring(const int *colors, void *arg) {
+  struct checksum *c = arg;
+
+  for (int v = 0; v < c->n; v++)
+    c->sum = c->sum * 31 + colors[v];
+}
+
+// [Auxiliary] Counts the calls to the progress callback of a thread
+
+static void count_progress(const struct mapcol_stats *stats, void *arg) {
+  struct worker *w = arg;
+  w->progress_calls++;
+}
+
+// [Auxiliary] Returns true if the colors of a solve are a valid coloring
+// of a test map (the precolor is kept, and neighbours differ)
+
+static bool valid_coloring(struct test_map *t, const int *colors) {
+  if (t->precolored != -1 && colors[t->precolored] != 0) return false;
+
+  for (int v = 0; v < t->n; v++)
+    if (colors[v] < 0 || colors[v] >= t->options.n_colors) return false;
+
+  for (int i = 0; i < t->n_edges; i++)
+    if (colors[t->from[i]] == colors[t->to[i]]) return false;
+
+  return true;
+}
+
+// [Auxiliary] Makes the calls of a test map on a new handle, and stores
+// their results in the test map (if record is true) or compares them with
+// the ones stored there. Returns the number of mismatches
+
+static int run(struct test_map *t, bool record, struct worker *w) {
+  struct mapcol *m = build(t);
+  struct mapcol_options options = t->options;
+  int failures = 0;
+
+  if (w != NULL) {
+    options.progress = count_progress;
+    options.progress_arg = w;
+  }
+
+  enum mapcol_status status = mapcol_solve(m, &options);
+  const int *colors = mapcol_colors(m);
+
+  if (record) {
+    t->status = status;
+    t->colors = test_alloc(sizeof(int) * t->n);
+    memcpy(t->colors, colors, sizeof(int) * t->n);
+
+    if (status != MAPCOL_OK || !valid_coloring(t, colors)) {
+      fprintf(stderr, "concurrent: %s: not colored\n", t->name);
+      failures++;
+    }
+  } else if (status != t->status
+          || memcmp(colors, t->colors, sizeof(int) * t->n) != 0) {
+    fprintf(stderr, "concurrent: %s: the solve differs\n", t->name);
+    failures++;
+  }
+
+  if (t->count_colors > 0) {
+    const char *count;
+
+    if (mapcol_count(m, t->count_colors, 0, &count) != MAPCOL_OK) {
+      fprintf(stderr, "concurrent: %s: %s\n", t->name, mapcol_error(m));
+      failures++;
+    } else if (record) {
+      t->count = test_alloc(strlen(count));
+      strcpy(t->count, count);
+    } else if (strcmp(count, t->count) != 0) {
+      fprintf(stderr, "concurrent: %s: the count differs\n", t->name);
+      failures++;
+    }
+  }
+
+  if (t->enumerate_colors > 0) {
+    struct checksum c = {t->n, 0};
+    long found = mapcol_enumerate(m, t->enumerate_colors, 0, add_coloring,
+                                  &c);
+
+    if (record) {
+      t->n_colorings = found;
+      t->checksum = c.sum;
+    } else if (found != t->n_colorings || c.sum != t->checksum) {
+      fprintf(stderr, "concurrent: %s: the enumeration differs\n", t->name);
+      failures++;
+    }
+  }
+
+  mapcol_destroy(m);
+  return failures;
+}
+
+// [Auxiliary] Counts and enumerates the colorings of the random map, which
+// is too wide for dynamic programming and has far too many colorings to be
+// found by backtracking, with a short timeout. Returns the number of calls
+// that weren't cut short in time
+
+static int run_timeouts(void) {
+  struct test_map *t = &maps[2];
+  struct mapcol *m = build(t);
+  struct checksum c = {t->n, 0};
+  const char *count;
+  int failures = 0;
+
+  if (mapcol_count(m, t->options.n_colors, 0.05, &count) != MAPCOL_TIMEOUT
+   || count != NULL || !mapcol_report(m)->cut_short) {
+    fprintf(stderr, "concurrent: %s: the count wasn't cut short\n", t->name);
+    failures++;
+  }
+
+  if (mapcol_enumerate(m, t->options.n_colors, 0.05, add_coloring, &c) < 0
+   || !mapcol_report(m)->cut_short) {
+    fprintf(stderr, "concurrent: %s: the enumeration wasn't cut short\n",
+            t->name);
+    failures++;
+  }
+
+  mapcol_destroy(m);
+  return failures;
+}
+
+// [Auxiliary] Thread function: runs every test map a few times, starting
+// from a different one on each thread
+
+static void * work(void *arg) {
+  struct worker *w = arg;
+  int first = w->index % N_MAPS;
+
+  for (int round = 0; round < N_ROUNDS; round++)
+    for (int i = 0; i < N_MAPS; i++)
+      w->failures += run(&maps[(first + i) % N_MAPS], false, w);
+
+  return NULL;
+}
+
+int main(void) {
+  struct worker workers[N_THREADS] = {0};
+  int failures = 0;
+  long progress_calls = 0;
+
+  make_maps();
+
+  for (int i = 0; i < N_MAPS; i++)
+    failures += run(&maps[i], true, NULL);
+
+  // Sanity checks of the results themselves (K8 has 9!/1! colorings with
+  // 9 colors, and 8! with 8 colors, and the triangulated grid has a
+  // single 3-coloring up to a permutation of the colors)
+
+  if (strcmp(maps[3].count, "362880") != 0 || maps[3].n_colorings != 40320
+   || strcmp(maps[1].count, "2") != 0) {
+    fprintf(stderr, "concurrent: wrong number of colorings\n");
+    failures++;
+  }
+
+  failures += run_timeouts();
+
+  for (int i = 0; i < N_THREADS; i++) {
+    workers[i].index = i;
+
+    if (pthread_create(&workers[i].thread, NULL, work, &workers[i]) != 0) {
+      fprintf(stderr, "concurrent: can't create a thread\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  for (int i = 0; i < N_THREADS; i++) {
+    pthread_join(workers[i].thread, NULL);
+    failures += workers[i].failures;
+    progress_calls += workers[i].progress_calls;
+  }
+
+  for (int i = 0; i < N_MAPS; i++) {
+    free(maps[i].from);
+    free(maps[i].to);
+    free(maps[i].colors);
+    free(maps[i].count);
+  }
+
+  if (failures > 0) {
+    fprintf(stderr, "concurrent: %d failures\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  printf("concurrent: %d threads x %d rounds x %d maps passed (%ld progress "
+         "reports)\n", N_THREADS, N_ROUNDS, N_MAPS, progress_calls);
+  return 0;
+}